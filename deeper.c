@@ -18,13 +18,17 @@
 #include <string.h>	// strdup
 #include <stdlib.h>	// rand, malloc, and much much more
 #include <sys/mman.h>	// mmap
+#include <sys/resource.h>	// getrusage
 #include <sys/stat.h>	// fstat
 #include <fcntl.h>	// open, etc
 #include <strings.h>	// str*
 #include <unistd.h>	// getopt, seek
+#include <getopt.h>	// getopt_long
 #include <ctype.h>	// isupper, etc
 #include <limits.h>	// LONG_MAX
 #include <errno.h>	// errno
+#include <pthread.h>	// worker pool
+#include <sched.h>	// sched_yield
 
 #if defined(__sun)
 #include <sys/types.h>
@@ -34,6 +38,10 @@
 #include <linux/types.h>
 #include <time.h>
 #include <stdint.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>	// LLC miss counter for --genbench
+#include <sys/syscall.h>
+#endif
 #endif	/* sun */
 
 #include "deeper.h"
@@ -61,6 +69,8 @@ ffb(uint32_t w)
 #endif
 
 void printmove(move_t *m, int rev);
+int lah(position_t *P, int depth, int limit);
+int lahval(position_t *P, int depth, int limit, int floor);
 /* Globals. */
 
 /* dictionary */
@@ -68,15 +78,50 @@ gn_t *gaddag = NULL;		// dictionary data (mmapped buffer) RDONLY
 bs_t *bitset = NULL;		// bitset data (mmapped) RDONLY
 int dfd = -1;			// dictionary file desc
 int bsfd = -1;			// bitset filed desc
+void *dictmap = NULL;		// all of name.dict, if that's what we have
+size_t dictlen = 0;
+void *gdmap = NULL;		// or name.gaddag
+size_t gdmaplen = 0;
+void *bsmap = NULL;		// and name.bitset
+size_t bsmaplen = 0;
+gnbs_t *pairs = NULL;		// paired layout, from name.dict or made
+int layout = LAYOUT_SPLIT;	// --layout
+int gshift = 0;			// 1 when paired
+int dmflags = 0;		// --dictmap DM_ bits
 char *dfn = NULL;		// dictionary file name
 unsigned long g_cnt = 0;	// how big is gaddag (in entries)
+int dictorder = DO_DFS;		// how mkgaddag numbered the nodes
+#ifdef DICTPROF
+uint64_t *dprof = NULL;		// looks at each node, deeper-dprof
+#endif
 
-/* bag */
-bag_t globalbag = NULL;		// we only do 1 bag at a time
+/* bag. per thread, so -g can play several at once */
+__thread bag_t globalbag = NULL;	// we only do 1 bag at a time
 bagstr_t bagstr = NULL;		// printable/readable bag contents
-char bagtag = '_';		// A-Z character naming bag/problem set
-char *bagname = NULL;		// name bag as string
-int baglen = 100;		// strlen(bagstr)
+__thread char bagtag = '_';	// A-Z character naming bag/problem set
+__thread char *bagname = NULL;	// name bag as string
+__thread int baglen = 100;	// strlen(bagstr)
+__thread uint64_t bagkey = 0;	// table keys differ per bag with -g
+int batchn = 0;			// -g: bags to play, or BATCHALL
+int batchfirst = 1;		// -g m-n: random bags start at m
+uint64_t seed = 0;		// --seed, for the random bags
+int seeded = 0;			// was it given?
+
+/* --bench */
+int benching = 0;		// games to play, and time
+__thread uint64_t bgens = 0;	// genall_d calls so far
+__thread uint64_t bgmoves = 0;	// moves they made
+__thread hrtime_t bgtime = 0;	// and how long they took
+uint64_t benchgens = 0;		// the same, summed over threads
+uint64_t benchgmoves = 0;
+hrtime_t benchgtime = 0;
+benchmv_t *benchmvs = NULL;	// moves of the game, to time makemove
+int benchnmv = 0;
+FILE *corpf = NULL;		// --corpus: positions of the games played
+char *corpfn = NULL;		// its name
+int corpbin = 0;		// posrec_t's, not lines, if it ends in .bin
+char *genfn = NULL;		// --genbench corpus
+volatile int batchnext = 0;	// next one to start
 
 /* rack */
 char *rackstr = NULL;
@@ -86,7 +131,7 @@ static const rack_t emptyrack = { {0,0,0,0,0,0,0,0 } };		// all nulls
 static const move_t emptymove = { 0, 0, 0, 0, 0, 0, { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}};
 board_t emptyboard;		// no tiles played
 board_t startboard;		// legal start moves marked
-gstats_t nullstats = { 0,0,0,0,0,0,0};	// all 0s
+gstats_t nullstats = { 0,0,0,0,0,0,0,0,0,0,0,0};	// all 0s
 position_t startp;
 static const scthingy_t newsct = { 0, 0, 1, 0, 0, 0, 0, 0, 1, 0 };
 
@@ -96,7 +141,8 @@ unsigned long dflags = 0;	// for DBG statements
 int stats = 0;			// report stats while running
 char *gcgfn = NULL;		// save result here
 gstats_t globalstats;		// global statistics
-unsigned long gmcnt = 0;	// global mv counter.
+__thread unsigned long gmcnt = 0;	// per thread mv counter.
+unsigned long wmcnt = 0;	// worker mv counts, folded in when idle
 
 /* other options */
 int doscore = 0;	// report scores as well
@@ -105,10 +151,46 @@ int level = 0;		// degree of strategy strength
 char *infile = 0;	// move input file.
 int strat = 0;		// move choosing strategy.
 int dostats = 0;	// how much stat info to report.
+int prune = 0;		// branch and bound in look-ahead
+int beamw = 8;		// games kept by beam search
+int rollc = 0;		// moves to roll out per turn, 0 for all
 
 /* job/process control */
 int dtrap = 0;			// debugger trap counter
-int globaldone = 0;		// set to stop all threads.
+__thread volatile int globaldone = 0;	// set to stop this thread's search.
+__thread hrtime_t deadline = 0;	// globaldone gets set after this. 0 for never
+hrtime_t budget = 0;		// --time-budget, in nsec
+__thread unsigned int ticks = 0;	// searches since the clock was read
+int nthreads = 1;		// search threads, including main.
+int poolsize = 0;		// workers actually started
+pthread_t workers[MAXTHREADS];
+pthread_mutex_t poollock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t poolcv = PTHREAD_COND_INITIALIZER;	// search started
+pthread_cond_t donecv = PTHREAD_COND_INITIALIZER;	// workers went idle
+volatile int poolrun = 0;	// a threaded search is running
+int jobgen = 0;			// bumped for each search
+int busy = 0;			// workers still in the search
+deque_t dq[MAXTHREADS];		// task deques, one per thread
+gstats_t tstats[MAXTHREADS];	// per thread steal and idle counts
+__thread int mytid = 0;		// index into dq, tstats. main is 0
+__thread int helping = 0;	// nested steals while waiting to join
+#define MAXHELP	8		// limit on the above
+
+/* checkpoint/restart */
+char *ckfn = NULL;		// -k checkpoint file
+int ckresume = 0;		// -r: start from it
+move_t *ckmvs = NULL;		// moves of the game so far
+int cknm = 0;			// how many
+hrtime_t cklast = 0;		// when the last checkpoint was written
+ckhead_t ckres;			// part way search to resume. k = 0 for none
+
+/* transposition table */
+int ttmb = 0;			// -h size in MB, 0 for none
+ttent_t *ttab = NULL;		// buckets of TTWAYS entries
+uint64_t ttmask = 0;		// buckets - 1
+uint64_t zboard[BOARDX][BOARDY][64];	// zobrist keys: letter on square
+uint64_t zrack[64][RACKSIZE+1];		// nth copy of letter in rack
+uint64_t zbag[256];			// bag index, mod 256
 
 void
 usage(char *me)
@@ -124,23 +206,46 @@ usage(char *me)
 	"\t-P: set playthru mode for moves\n"
 	"\t-I file: read moves from input file\n");
 
-	vprintf(VNORM, "%s -T n [-n lvl] [-b bag] [-B str]\n", me);
+	vprintf(VNORM, "%s -T n [-n lvl] [-p] [-w n] [-c n] [-e sec] [-j n] [-h MB] [-b bag] [-B str]\n", me);
 	vprintf(VVERB,
 	"\t-T n: use strategy number n to play game\n"
 	"\t-n lvl: for progressive strats, use level lvl\n"
+	"\t-p: prune look-ahead lines that can't beat the best so far\n"
+	"\t-w n: beam width for strategy 7 [default=8]\n"
+	"\t-c n: strategy 8 rolls out only the n best moves [default=all]\n"
+	"\t-e sec, --time-budget sec: strategy 9 plays the game in sec seconds\n"
+	"\t-j n: search with n threads [default=1]\n"
+	"\t-h MB: use a transposition table of MB megabytes [default=0]\n"
 	"\t-b [?]A-Z|name: Set bag name. A-Z are built-in, ?=randomize.\n"
+	"\t--seed n: random bags come from seed n, and are the same each run\n"
 	"\t-B str: set bag to string of tiles (A-Z or ? for blank.\n");
-	vprintf(VNORM, "    [-D bits|word] [-vqts] [-d dict]\n");
+	vprintf(VNORM, "    [-D bits|word] [-vqts] [-d dict] [--layout split|paired]\n"
+	    "    [--dictmap huge,populate,lock]\n");
 	vprintf(VVERB,
 	"\t-D bits|word turn on specified debug flags\n"
 	"\t-v: increase verbosity level, cumulative\n"
 	"\t-q: no messages, only return values. Cancels -v.\n"
 	"\t-t: time and report operations\n"
 	"\t-s: collect and report statistics. Use twice for more.\n"
-	"\t-d name: use name.gaddag as dictionary. [default=ENABLE]\n");
-	vprintf(VNORM, "    [-o file] [-R str]\n");
+	"\t-d name: use name.dict as dictionary, or name.gaddag and\n"
+	"\t    name.bitset. [default=ENABLE]\n"
+	"\t--layout split|paired: keep each gaddag node's bitset in its own\n"
+	"\t    array, or next to the node [default=split]\n"
+	"\t--dictmap huge,populate,lock: put the dictionary in huge pages,\n"
+	"\t    prefault it, lock it in memory. -v says which worked.\n");
+	vprintf(VNORM, "    [-o file] [-R str] [-k file [-r]] [-g all|n] [--bench n]\n"
+	    "    [--corpus file] [--genbench file]\n");
 	vprintf(VVERB,
-	"\t-o name: save best move to name.gcg\n"
+	"\t-o name: save the game to name.gcg, or name-bag.gcg with -g\n"
+	"\t-k file: checkpoint strategy 5 to file every few seconds\n"
+	"\t-r: restart from the -k checkpoint\n"
+	"\t-g all|n|m-n: play -T on bags A-Z, or shaken bags 1-n or m-n,\n"
+	"\t    -j at a time. Shaken bag 1 is the one -b ? gets.\n"
+	"\t--bench n: play the -b bag n times, print a csv line of timings\n"
+	"\t--corpus file: add each position played to file, as lines of\n"
+	"\t    board rack bagndx score bag, or binary if file ends in .bin\n"
+	"\t--genbench file: time and check the move generators on a corpus,\n"
+	"\t    --bench n times over\n"
 	"\t-R str: set rack to string of tiles (A-Z or ? for blank.)\n");
 	vprintf(VVERB,
 	"\t move = rc:word or cr:word, r=1-15, c=A-O, word is 1-15 letters.\n"
@@ -321,8 +426,268 @@ hrtime_t gethrtime()
 }
 #endif
 
+/*
+ * has the search run out of time? Only reads the clock every 64th
+ * call. Each thread keeps its own deadline and globaldone. Pool
+ * threads get the deadline with each task, and read the clock when it
+ * starts. That way a task begun late doesn't search its whole subtree
+ * before its 64th call.
+ */
+inline int
+timeup()
+{
+	if (globaldone) return 1;
+	if ((deadline != 0) && ((++ticks & 63) == 0) && (gethrtime() > deadline)) {
+		globaldone = 1;
+	}
+	return globaldone;
+}
+
+/*
+ * crc-32 (the zip/ethernet one) of len bytes at buf, carrying on from
+ * crc. Start with 0.
+ */
+uint32_t
+crcup(uint32_t crc, const void *buf, size_t len)
+{
+	static uint32_t tab[256];
+	const uint8_t *p = buf;
+	uint32_t c;
+	int i, k;
+
+	if (tab[1] == 0) {
+		for (i = 0; i < 256; i++) {
+			c = i;
+			for (k = 0; k < 8; k++) {
+				c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+			}
+			tab[i] = c;
+		}
+	}
+	crc = ~crc;
+	while (len-- > 0) {
+		crc = tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+#ifdef DICTPROF
+/* count a look at node n. Threads can lose a few; it's only a profile. */
+inline unsigned long
+dprofhit(unsigned long n)
+{
+	if (dprof != NULL) dprof[n]++;
+	return n;
+}
+
+/* name.prof: a uint64_t count for each node, for mkgaddag -o hot -P. */
 int
-getdict(char *name)
+dprofsave(char *name)
+{
+	char fn[1024];
+	FILE *f;
+	int rv = 0;
+
+	if (dprof == NULL) return 0;
+	snprintf(fn, sizeof(fn), "%s%s", name, PROFEND);
+	f = fopen(fn, "w");
+	if (f == NULL) {
+		VERB(VNORM, "ERROR: profile ") {
+			perror(fn);
+		}
+		return -1;
+	}
+	if (fwrite(dprof, sizeof(uint64_t), g_cnt, f) != g_cnt) rv = -1;
+	if (fclose(f) != 0) rv = -1;
+	if (rv < 0) {
+		VERB(VNORM, "ERROR: profile ") {
+			perror(fn);
+		}
+	} else {
+		vprintf(VVERB, "wrote %lu node counts to %s\n", g_cnt, fn);
+	}
+	return rv;
+}
+#endif
+
+/*
+ * make sure the gaddag and bitset go together: every child is in
+ * range, every letter is one, the last node ends its sibs, and each
+ * gbits(n) is the letters of nodes n to the end of its sibs, the
+ * way mkgaddag makes them. Returns how many nodes are wrong.
+ */
+int
+dictcheck()
+{
+	bs_t bits = 0;
+	long n;
+	int bad = 0;
+
+	if ((g_cnt < 2) || !gs(gnode(g_cnt - 1))) return 1;
+	for (n = g_cnt - 1; n >= 0; n--) {
+		if (gs(gnode(n))) bits = 0;
+		if ((gl(gnode(n)) > SEP) || (gc(gnode(n)) >= g_cnt)) {
+			bad++;
+			continue;
+		}
+		bits |= gl(gnode(n)) ? l2b(gl(gnode(n))) : 0x80000000;
+		if (gbits(n) != bits) bad++;
+	}
+	return bad;
+}
+
+#if defined(MAP_POPULATE)
+#define MMPOP	((dmflags & DM_POPULATE) ? MAP_POPULATE : 0)
+#else
+#define MMPOP	0
+#endif
+
+/*
+ * map name.dict, and point gaddag and bitset into it. The header and
+ * every section have to check out. Returns g_cnt, 0 if there's no
+ * such file, or < 0 if it's no good.
+ */
+int
+loaddict(char *fullname)
+{
+	dicthead_t *h;
+	dictsect_t *sp;
+	struct stat st;
+	uint32_t crc;
+	int i, fd;
+	int want = DS_GADDAG;
+
+	fd = open(fullname, O_RDONLY);
+	if (fd < 0) {
+		if (errno == ENOENT) return 0;
+		VERB(VNORM, "dictionary file %s failed to open\n", fullname) {
+			perror("open");
+		}
+		return -1;
+	}
+	if (fstat(fd, &st) < 0) {
+		VERB(VNORM, "cannot fstat open file %s\n", fullname) {
+			perror("fstat");
+		}
+		close(fd);
+		return -2;
+	}
+	if (st.st_size < sizeof(dicthead_t)) {
+		vprintf(VNORM, "%s is too short for a dictionary\n", fullname);
+		close(fd);
+		return -3;
+	}
+	dictlen = st.st_size;
+	dictmap = mmap(0, dictlen, PROT_READ, MAP_SHARED | MMPOP, fd, 0);
+	close(fd);
+	if (dictmap == MAP_FAILED) {
+		VERB(VNORM, "failed to mmap %lu bytes of dictionary\n", dictlen) {
+			perror("mmap");
+		}
+		dictmap = NULL;
+		return -4;
+	}
+	h = dictmap;
+	gaddag = NULL;
+	bitset = NULL;
+	pairs = NULL;
+	if (h->magic != DICTMAGIC) {
+		vprintf(VNORM, "%s is not a dictionary\n", fullname);
+		goto bad;
+	}
+	if (h->bom != DICTBOM) {
+		vprintf(VNORM, "%s was made on a machine with the other byte order\n", fullname);
+		goto bad;
+	}
+	if (h->version != DICTVERSION) {
+		vprintf(VNORM, "%s is version %u, not %d\n", fullname, h->version, DICTVERSION);
+		goto bad;
+	}
+	{
+		dicthead_t th = *h;
+
+		th.crc = 0;
+		crc = crcup(0, &th, sizeof(th));
+	}
+	if ((crc != h->crc) || (h->nsects > DICTSECTS)) {
+		vprintf(VNORM, "%s header is damaged\n", fullname);
+		goto bad;
+	}
+	g_cnt = h->nodes;
+	dictorder = h->order;
+	/* only check what gets used: the pairs, or else gaddag and bitset */
+	for (i = 0; i < h->nsects; i++) {
+		if ((h->sect[i].type == DS_PAIRED) && (layout == LAYOUT_PAIRED)) {
+			want = DS_PAIRED;
+		}
+	}
+	for (i = 0; i < h->nsects; i++) {
+		sp = &(h->sect[i]);
+		if ((sp->off % sizeof(gnbs_t)) || (sp->off > dictlen) ||
+		    (sp->len > dictlen - sp->off)) {
+			vprintf(VNORM, "%s section %d is out of bounds\n", fullname, i);
+			goto bad;
+		}
+		if ((sp->type == DS_PAIRED) != (want == DS_PAIRED)) continue;
+		if (crcup(0, (char *)dictmap + sp->off, sp->len) != sp->crc) {
+			vprintf(VNORM, "%s section %d is damaged\n", fullname, i);
+			goto bad;
+		}
+		if ((sp->type == DS_GADDAG) && (sp->len == g_cnt * sizeof(gn_t))) {
+			gaddag = (gn_t *)((char *)dictmap + sp->off);
+		} else if ((sp->type == DS_BITSET) && (sp->len == g_cnt * sizeof(bs_t))) {
+			bitset = (bs_t *)((char *)dictmap + sp->off);
+		} else if ((sp->type == DS_PAIRED) && (sp->len == g_cnt * sizeof(gnbs_t))) {
+			pairs = (gnbs_t *)((char *)dictmap + sp->off);
+			gaddag = &(pairs->n);
+			bitset = &(pairs->bs);
+		}
+	}
+	if ((gaddag == NULL) || (bitset == NULL)) {
+		vprintf(VNORM, "%s has no gaddag or bitset for %lu nodes\n", fullname, g_cnt);
+		goto bad;
+	}
+	vprintf(VVERB, "dictionary %s: %u words, %lu nodes, order %u\n", fullname, h->words, g_cnt, h->order);
+	return g_cnt;
+bad:
+	munmap(dictmap, dictlen);
+	dictmap = NULL;
+	gaddag = NULL;
+	bitset = NULL;
+	pairs = NULL;
+	return -5;
+}
+
+/*
+ * --layout paired, but the file doesn't have them: make the pairs from
+ * the split gaddag and bitset. Returns 0, or -1 if there's no memory.
+ */
+int
+mkpairs()
+{
+	unsigned long n;
+
+	if (posix_memalign((void **)&pairs, 64, g_cnt * sizeof(gnbs_t)) != 0) {
+		vprintf(VNORM, "ERROR: no memory for %lu node pairs\n", g_cnt);
+		pairs = NULL;
+		return -1;
+	}
+	for (n = 0; n < g_cnt; n++) {
+		pairs[n].n = gaddag[n];
+		pairs[n].bs = bitset[n];
+	}
+	gaddag = &(pairs->n);
+	bitset = &(pairs->bs);
+	vprintf(VVERB, "made %lu node pairs\n", g_cnt);
+	return 0;
+}
+
+/*
+ * the old way: name.gaddag and name.bitset, made separately. Only their
+ * sizes can be checked here.
+ */
+int
+getsplit(char *name)
 {
 	char *fullname;
 	int rv;
@@ -368,12 +733,9 @@ getdict(char *name)
 #define MMFLAGS	MAP_SHARED | MAP_ALIGN
 	gaddag = (gn_t *)mmap((void *)GDSIZE, GDSIZE, PROT_READ, MMFLAGS, dfd, 0);
 #else
-// #define MMFLAGS	MAP_SHARED | MAP_HUGETLB | MAP_LOCKED | MAP_POPULATE
-// #define MMFLAGS	MAP_SHARED | MAP_LOCKED | MAP_POPULATE
-//#define MMFLAGS	MAP_SHARED | MAP_LOCKED
-//#define MMFLAGS	MAP_SHARED | MAP_HUGETLB
-#define MMFLAGS	MAP_SHARED
-	gaddag = (gn_t *)mmap(0, GDSIZE, PROT_READ, MMFLAGS, dfd, 0);
+/* --dictmap has the huge page and locking choices */
+#define MMFLAGS	MAP_SHARED | MMPOP
+	gaddag = (gn_t *)mmap(0, len, PROT_READ, MMFLAGS, dfd, 0);
 #endif
 	if (gaddag == MAP_FAILED) {
 		VERB(VNORM, "failed to mmap %d bytes of gaddag\n", len) {
@@ -381,6 +743,12 @@ getdict(char *name)
 		}
 		return -4;
 	}
+	gdmap = gaddag;
+#if defined(__sun)
+	gdmaplen = GDSIZE;
+#else
+	gdmaplen = len;
+#endif
 #if defined(__sun)
 	{
 		struct memcntl_mha mha;
@@ -428,7 +796,7 @@ getdict(char *name)
 #if defined(__sun)
 	bitset = (bs_t *)mmap((void *)GDSIZE, GDSIZE, PROT_READ, MMFLAGS, bsfd, 0);
 #else
-	bitset = (bs_t *)mmap(0, GDSIZE, PROT_READ, MAP_SHARED, bsfd, 0);
+	bitset = (bs_t *)mmap(0, len, PROT_READ, MMFLAGS, bsfd, 0);
 #endif
 	if (bitset == MAP_FAILED) {
 		VERB(VNORM, "failed to mmap %d bytes of bitset\n", len) {
@@ -436,6 +804,12 @@ getdict(char *name)
 		}
 		return -4;
 	}
+	bsmap = bitset;
+#if defined(__sun)
+	bsmaplen = GDSIZE;
+#else
+	bsmaplen = len;
+#endif
 #if defined(__sun)
 	{
 		struct memcntl_mha mha;
@@ -456,6 +830,195 @@ getdict(char *name)
 	return g_cnt;
 }
 
+/* kB of transparent huge pages backing the mapping at p, or -1. */
+long
+thpkb(void *p)
+{
+	FILE *f;
+	char line[256];
+	unsigned long lo, hi;
+	long kb = -1;
+	int in = 0;
+
+	f = fopen("/proc/self/smaps", "r");
+	if (f == NULL) return -1;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+			if (in) break;
+			in = ((unsigned long)p >= lo) && ((unsigned long)p < hi);
+		} else if (in && (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)) {
+			break;
+		}
+	}
+	fclose(f);
+	return kb;
+}
+
+/*
+ * --dictmap huge: copy len bytes at p to huge pages, and return where
+ * they went. hugetlb pages if there are any set aside, else anonymous
+ * memory that asks for transparent huge pages. Or p, if neither works.
+ */
+void *
+dicthuge(void *p, size_t len, char *what)
+{
+	size_t hlen = (len + HUGESZ - 1) & ~(HUGESZ - 1);
+	char *h, *a;
+
+#if defined(MAP_HUGETLB)
+	h = mmap(0, hlen, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (h != MAP_FAILED) {
+		memcpy(h, p, len);
+		mprotect(h, hlen, PROT_READ);
+		vprintf(VVERB, "%s: %lu kB in hugetlb pages\n", what, hlen / 1024);
+		return h;
+	}
+#endif
+#if defined(MADV_HUGEPAGE)
+	/* get a HUGESZ aligned piece, or the ends can't be huge */
+	h = mmap(0, hlen + HUGESZ, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (h != MAP_FAILED) {
+		a = (char *)(((uintptr_t)h + HUGESZ - 1) & ~(HUGESZ - 1));
+		if (a > h) munmap(h, a - h);
+		munmap(a + hlen, (h + hlen + HUGESZ) - (a + hlen));
+		if (madvise(a, hlen, MADV_HUGEPAGE) == 0) {
+			memcpy(a, p, len);
+			mprotect(a, hlen, PROT_READ);
+			vprintf(VVERB, "%s: %ld kB of %lu kB in transparent huge pages\n",
+			    what, thpkb(a), hlen / 1024);
+			return a;
+		}
+		VERB(VVERB, "%s: no transparent huge pages: ", what) {
+			perror("madvise");
+		}
+		munmap(a, hlen);
+	}
+#endif
+	vprintf(VVERB, "%s: no huge pages, left as it was\n", what);
+	return p;
+}
+
+/*
+ * unmap *mp if gaddag and bitset don't point into it any more: they
+ * were copied to huge pages, or into pairs. Else it's there twice.
+ */
+void
+dictunmap(void **mp, size_t len, char *what)
+{
+	char *m = *mp;
+
+	if (m == NULL) return;
+	if (((char *)gaddag >= m) && ((char *)gaddag < m + len)) return;
+	if (((char *)bitset >= m) && ((char *)bitset < m + len)) return;
+	munmap(m, len);
+	*mp = NULL;
+	vprintf(VVERB, "%s: unmapped, %lu kB\n", what, len / 1024);
+}
+
+/* --dictmap lock: keep len bytes at p in memory. */
+void
+dictlock(void *p, size_t len, char *what)
+{
+	if (mlock(p, len) == 0) {
+		vprintf(VVERB, "%s: %lu kB locked\n", what, len / 1024);
+	} else {
+		VERB(VVERB, "%s: not locked: ", what) {
+			perror("mlock");
+		}
+	}
+}
+
+/*
+ * find the dictionary: name.dict, or else name.gaddag and name.bitset.
+ * Either way, check the bitset goes with the gaddag; a stale one would
+ * quietly make wrong moves. Returns g_cnt, or <= 0 if there's none.
+ */
+int
+getdict(char *name)
+{
+	char *fullname;
+	hrtime_t fore = gethrtime();
+	struct rusage ru0, ru1;
+	gnbs_t *np;
+	int rv, bad;
+
+	getrusage(RUSAGE_SELF, &ru0);
+	if (name == NULL) {
+		name = DDFN;
+	}
+	fullname = malloc(strlen(name) + strlen(DICTEND) + 1);
+	if (fullname == NULL) {
+		VERB(VNORM, "failed to alloc %d bytes for filename\n", strlen(name) + strlen(DICTEND) + 1) {
+			perror("malloc");
+		}
+		return -5;
+	}
+	strcpy(fullname, name);
+	strcat(fullname, DICTEND);
+	rv = loaddict(fullname);
+	free(fullname);
+	if (rv == 0) {
+		rv = getsplit(name);
+	}
+	if (rv <= 0) return rv;
+	if (layout == LAYOUT_PAIRED) {
+		if ((pairs == NULL) && (mkpairs() < 0)) return -5;
+		gshift = 1;
+	}
+	vprintf(VVERB, "dictionary layout %s\n", (gshift) ? "paired" : "split");
+	if (dmflags & DM_POPULATE) {
+#if defined(MAP_POPULATE)
+		vprintf(VVERB, "dictionary mapped with MAP_POPULATE\n");
+#else
+		vprintf(VVERB, "no MAP_POPULATE here, dictionary pages fault in as used\n");
+#endif
+	}
+	if ((dmflags & DM_HUGE) && gshift) {
+		np = dicthuge(pairs, g_cnt * sizeof(gnbs_t), "pairs");
+		if ((np != pairs) && ((dictmap == NULL) || ((char *)pairs < (char *)dictmap) ||
+		    ((char *)pairs >= (char *)dictmap + dictlen))) {
+			free(pairs);	/* mkpairs made them */
+		}
+		pairs = np;
+		gaddag = &(pairs->n);
+		bitset = &(pairs->bs);
+	} else if (dmflags & DM_HUGE) {
+		gaddag = dicthuge(gaddag, g_cnt * sizeof(gn_t), "gaddag");
+		bitset = dicthuge(bitset, g_cnt * sizeof(bs_t), "bitset");
+	}
+	dictunmap(&dictmap, dictlen, "dictionary file");
+	dictunmap(&gdmap, gdmaplen, "gaddag file");
+	dictunmap(&bsmap, bsmaplen, "bitset file");
+	if ((dmflags & DM_LOCK) && gshift) {
+		dictlock(pairs, g_cnt * sizeof(gnbs_t), "pairs");
+	} else if (dmflags & DM_LOCK) {
+		dictlock(gaddag, g_cnt * sizeof(gn_t), "gaddag");
+		dictlock(bitset, g_cnt * sizeof(bs_t), "bitset");
+	}
+	bad = dictcheck();
+	if (bad) {
+		vprintf(VNORM, "%d gaddag nodes or bitsets are wrong. Remake the dictionary.\n", bad);
+		return -6;
+	}
+#ifdef DICTPROF
+	/* after the check, so it doesn't count every node once */
+	if (dictorder != DO_DFS) {
+		vprintf(VNORM, "ERROR: no profile, %s%s isn't in depth first order\n", name, DICTEND);
+	} else {
+		dprof = calloc(g_cnt, sizeof(uint64_t));
+		if (dprof == NULL) {
+			vprintf(VNORM, "ERROR: no memory to profile %lu nodes\n", g_cnt);
+		}
+	}
+#endif
+	getrusage(RUSAGE_SELF, &ru1);
+	vprintf(VVERB, "dictionary loaded and checked in %llu usec, %ld page faults\n",
+	    (gethrtime() - fore) / 1000, ru1.ru_minflt - ru0.ru_minflt + ru1.ru_majflt - ru0.ru_majflt);
+	return rv;
+}
+
 void
 printlrstr(letter_t *lstr) {
 	char cstr[20] = "";
@@ -575,17 +1138,115 @@ pluckrack(rack_t *r, letter_t l)
 	return lp;
 }
 
+/* splitmix64, to fill the zobrist tables. */
+uint64_t
+zmix(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* zobrist keys. Fixed seed, so hashes are the same run to run. */
+void
+zinit()
+{
+	uint64_t x = 0x6465657065720001ULL;
+	int r, c, l;
+
+	for (r = 0; r < BOARDX; r++)
+		for (c = 0; c < BOARDY; c++)
+			for (l = 0; l < 64; l++)
+				zboard[r][c][l] = zmix(&x);
+	for (l = 0; l < 64; l++)
+		for (c = 0; c <= RACKSIZE; c++)
+			zrack[l][c] = zmix(&x);
+	for (c = 0; c < 256; c++)
+		zbag[c] = zmix(&x);
+}
+
+/*
+ * full recompute of the board hash, by scanning all the spaces.
+ * makemove8 keeps b->hash up to date; this is for checking it.
+ * Played blanks hash differently than the real letter (BB is kept).
+ */
+uint64_t
+bdhash(board_t *b)
+{
+	uint64_t h = 0;
+	letter_t l;
+	int r, c;
+
+	for (r = 0; r < BOARDX; r++) {
+		for (c = 0; c < BOARDY; c++) {
+			l = b->spaces[r][c].b.f.letter;
+			if (l) h ^= zboard[r][c][l & 0x3F];
+		}
+	}
+	return h;
+}
+
+/*
+ * random bags. splitmix64 is small and fast, and mixes well enough
+ * that bag k's stream can start from a hash of k: any bag of a
+ * seeded run can be made without the ones before it.
+ */
+inline uint64_t
+splitmix(uint64_t *s)
+{
+	uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* 0 to n-1, all equally likely. Lemire's multiply and reject. */
+inline uint32_t
+randbelow(uint64_t *s, uint32_t n)
+{
+	uint64_t m = (splitmix(s) & 0xFFFFFFFFULL) * n;
+	uint32_t t;
+
+	if ((uint32_t)m < n) {
+		t = -n % n;
+		while ((uint32_t)m < t) {
+			m = (splitmix(s) & 0xFFFFFFFFULL) * n;
+		}
+	}
+	return m >> 32;
+}
+
+/* shake the bag, as bag number k of the run. Fisher-Yates. */
+void
+shakebag(bag_t bag, int len, int k)
+{
+	uint64_t s = k;
+	int i, j;
+	letter_t tl;
+
+	s = seed ^ splitmix(&s);
+	for (i = len - 1; i > 0; i--) {
+		j = randbelow(&s, i + 1);
+		tl = bag[i];
+		bag[i] = bag[j];
+		bag[j] = tl;
+	}
+}
+
 /* initialize a bunch of things. 0 = success. */
 int
 initstuff()
 {
 	int r, c;
-	unsigned int random;
+	int random = 0;
 
-	/* seed rng */
-	random = (getpid() * time(NULL)) >> 4;
-	srand(random);
-	random = 0;
+	/* seed rng, unless --seed did. */
+	if (!seeded) {
+		seed = ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL) ^ gethrtime();
+	}
 
 	/* bag. Names bags A-Z, or custom. '?' mean randomize */
 	bagtag = '\0';
@@ -622,25 +1283,13 @@ initstuff()
 		return 1;
 	}
 	if (random) {
-		int shakes;
-		int s1, s2, len;
-		letter_t tl;
-
-		len = strlen(globalbag);
-		shakes = len * len * 2;
-		/* shake the bag. */
-		while (shakes--) {
-			s1 = rand();
-			s2 = (s1/len) % len;
-			s1 %= len;
-			tl = globalbag[s1];
-			globalbag[s1] = globalbag[s2];
-			globalbag[s2] = tl;
-		}
-		vprintf(VVERB, "bag %s was shaken.\n", bagname);
+		shakebag(globalbag, strlen(globalbag), 1);
+		vprintf(VVERB, "bag %s was shaken with --seed %llu.\n", bagname, seed);
 	}
 
+	zinit();
 	/* set up empty board */
+	emptyboard.hash = 0;
 	for (r = 0; r < BOARDY; r++) {
 		for (c = 0; c < BOARDX; c++) {
 			emptyboard.spaces[r][c].b.all = 0;
@@ -716,9 +1365,9 @@ lcmp(const void *l1, const void *l2)
 void
 printnode(char *msg, uint32_t nid)
 {
-	char l = gl(gaddag[nid]);
-	printf("%s: node %d = [%d|%c|%c|%c(%d)]\n", msg, nid, gc(gaddag[nid]),
-gs(gaddag[nid])?'$': ' ', gf(gaddag[nid])? '.': ' ',l?l2c(l):' ',l );
+	char l = gl(gnode(nid));
+	printf("%s: node %d = [%d|%c|%c|%c(%d)]\n", msg, nid, gc(gnode(nid)),
+gs(gnode(nid))?'$': ' ', gf(gnode(nid))? '.': ' ',l?l2c(l):' ',l );
 }
 
 /*
@@ -747,9 +1396,9 @@ gotol(letter_t l, int nid)
 {
 	uint32_t bits;
 
-	bits = bitset[nid] << (32 -l);
+	bits = gbits(nid) << (32 -l);
 	return nid + popc(bits) - 1;
-//	return nid + popc(bitset[nid] << (32-l)) -1;
+//	return nid + popc(gbits(nid) << (32-l)) -1;
 }
 
 /* return the next letter, and fix up bs */
@@ -757,7 +1406,7 @@ inline letter_t
 nextl(bs_t *bs, int *curid)
 {
 	letter_t l;
-	uint32_t idbs = bitset[*curid];
+	uint32_t idbs = gbits(*curid);
 
 	l = ffb(*bs);
 	if (l==0) return 0;
@@ -778,10 +1427,10 @@ finals(int nid)
 	int newid;
 
 	if (nid < 0) return bs;		/* just in case */
-	nbs = bitset[nid];
+	nbs = gbits(nid);
 	l = nextl(&nbs, &nid);
 	while (l != '\0') {
-		if (gf(gaddag[nid])) {
+		if (gf(gnode(nid))) {
 			setbit(&bs, l-1);
 		}
 		l = nextl(&nbs, &nid);
@@ -876,24 +1525,25 @@ dobridge2(board_t *b, int nid, int row, int col, int dir, int end)
 	dr = end * dir;
 	dc = end * (1 - dir);
 
-	bs = bitset[nid];
+	bs = gbits(nid);
 	/* prune with other side of gap. */
 //	bs &= b->spaces[cr+dr][cc+dc].mnid[dir];
 	if (bs == 0) return 0;
 	while (gl = nextl(&bs, &curid)) {
 		gid = gotol(gl, curid);
-		gcid = gc(gaddag[gid]);
+		gcid = gc(gnode(gid));
+		cr = row; cc = col;
 		while ( (nl = ndn(b, cr, cc, dir, end)) > 0) {
-			if (l2b(nl) & bitset[gcid]) {
-				gid = gotol(gl, gcid);
-				gcid = gc(gaddag[gid]);
+			if (l2b(nl) & gbits(gcid)) {
+				gid = gotol(nl, gcid);
+				gcid = gc(gnode(gid));
 				if (gid <= 0) break;
 				cr += dr; cc += dc;
 			} else {
 				break;
 			}
 		}
-		if ((nl == 0) && (gf(gaddag[gid]))) {
+		if ((nl <= 0) && (gf(gnode(gid)))) {
 			setbit(&gbs, gl - 1);
 		}
 	}
@@ -925,12 +1575,12 @@ dobridge(board_t *b, int nid, int row, int col, int dir, int end)
 		b->spaces[row+dr][col+dc].mbs[1-dir] = 0;
 		return;
 	}
-//	gid = gc(gaddag[nid]);
+//	gid = gc(gnode(nid));
 	gid = nid;
-	nbs = bitset[gid];
+	nbs = gbits(gid);
 	while (spl = nextl(&nbs, &gid)) {
 		gid = gotol(spl, gid);
-		lid = gc(gaddag[gid]);
+		lid = gc(gnode(gid));
 		if (lid <= 0)  {
 			continue;
 		}
@@ -938,17 +1588,17 @@ dobridge(board_t *b, int nid, int row, int col, int dir, int end)
 		cc = col + 2* dc;
 		while ((wl = b->spaces[cr][cc].b.f.letter) != '\0') {
 			ASSERT(wl != '\0');
-			if ((!(l2b(wl) & bitset[lid])) || (lid <= 0)) {
+			if ((!(l2b(wl) & gbits(lid))) || (lid <= 0)) {
 				/* it's not a word. */
 				break;
 			}
-			if (nldn(b, cr, cc, dir, dr+dc) && gf(gaddag[lid])) {
+			if (nldn(b, cr, cc, dir, dr+dc) && gf(gnode(lid))) {
 				setbit(&fbs, spl - 1);
 				break;
 			}
 			cr+=dr;cc+=dc;
 			lid = gotol(wl,lid);
-			lid = gc(gaddag[lid]);
+			lid = gc(gnode(lid));
 		}
 	}
 	b->spaces[row+dr][col+dc].mbs[1-dir] = fbs;
@@ -971,7 +1621,7 @@ doanagram_e(uint32_t nodeid, letter_t *sofar, int depth, letter_t *rest)
 	lbs = lstr2bs(rest);
 
 	curid = nodeid;
-	bs = bitset[nodeid] & lbs;
+	bs = gbits(nodeid) & lbs;
 	while (l = nextl(&bs, &curid)) {
 DBG(DBG_ANA, "matched %c from ", l2c(l)) {
 		printlstr(rest);
@@ -981,19 +1631,19 @@ DBG(DBG_ANA, "matched %c from ", l2c(l)) {
 		/* remove l from rest. */
 		lp = strchr(rest, l);
 		*lp = MARK;
-		if (gf(gaddag[curid])) {
+		if (gf(gnode(curid))) {
 			anas++;
 			VERB(VNORM, " ") {
 				printlrstr(sofar); printf("\n");
 			}
 		}
-		anas += doanagram_e(gc(gaddag[curid]), sofar, depth+1, rest);
+		anas += doanagram_e(gc(gnode(curid)), sofar, depth+1, rest);
 		*lp = l;
 	}
 	/* if there is a '?', do another round. */
 	if (lbs & UBLBIT) {
 		curid = nodeid;
-		bs = ALLPHABITS & bitset[nodeid];
+		bs = ALLPHABITS & gbits(nodeid);
 		lp = strchr(rest, UBLANK);
 		*lp = MARK;
 		while (l = nextl(&bs, &curid)) {
@@ -1002,13 +1652,13 @@ DBG(DBG_ANA, "blank %c from ", l2c(l|BB)) {
 		printnode(" using", curid);
 }
 			sofar[depth] = l|BB;
-			if (gf(gaddag[curid])) {
+			if (gf(gnode(curid))) {
 				anas++;
 				VERB(VNORM, " ") {
 					printlrstr(sofar); printf("\n");
 				}
 			}
-			anas += doanagram_e(gc(gaddag[curid]), sofar, depth+1, rest);
+			anas += doanagram_e(gc(gnode(curid)), sofar, depth+1, rest);
 		}
 		*lp = UBLANK;
 	}
@@ -1099,34 +1749,34 @@ DBG(DBG_LOOK, "i=%d, word[i]=%c, nid=%d\n", i, l2c(l), nodeid);
 		b = l2b(l);
 		if (l == UBLANK) {
 			letter_t bl;
-			b = bitset[nodeid] & ALLPHABITS;
+			b = gbits(nodeid) & ALLPHABITS;
 			while (bl = nextl(&b, &nodeid)) {
 				/* recurse on blanks. */
 				word[i] = BB | bl;
 DBG(DBG_LOOK, "i=%d, blank=%c nid=%d word=",i, l2c(BB|bl), nodeid) {
 	printlstr(word); printf("\n");
 }
-				if ((i <= 0) && ( gf(gaddag[nodeid]))) {
+				if ((i <= 0) && ( gf(gnode(nodeid)))) {
 					matchcount++;
 					VERB(VNORM, " ") {
 						printlstr(word); printf("\n");
 					}
 				}
 				if (i>0)
-					matchcount += bs_lookup(i, word, gc(gaddag[nodeid]));
+					matchcount += bs_lookup(i, word, gc(gnode(nodeid)));
 			}
 			word[i] = UBLANK;
 			break;
-		} else if (b & bitset[nodeid]) {
+		} else if (b & gbits(nodeid)) {
 			nodeid = gotol(l, nodeid);
-			if ((i == 0) && ( gf(gaddag[nodeid]))) {
+			if ((i == 0) && ( gf(gnode(nodeid)))) {
 				matchcount++;
 				VERB(VNORM, " ") {
 					printlstr(word); printf("\n");
 				}
 				break;
 			}
-			nodeid = gc(gaddag[nodeid]);
+			nodeid = gc(gnode(nodeid));
 		} else {
 			break;
 		}
@@ -1152,14 +1802,14 @@ DBG(DBG_LOOK, "i=%d, word[i]=%c, nid=%d\n", i, l2c(l), nodeid);
 		b = l2b(l);
 		if (l == UBLANK) {
 			letter_t bl;
-			b = bitset[nodeid] & ALLPHABITS;
+			b = gbits(nodeid) & ALLPHABITS;
 			while (bl = nextl(&b, &nodeid)) {
 				/* recurse on blanks. */
 				word[i] = BB | bl;
 DBG(DBG_LOOK, "i=%d, blank=%c nid=%d word=",i, l2c(BB|bl), nodeid) {
 	printlstr(word); printf("\n");
 }
-				if ((i <= 0) && ( gf(gaddag[nodeid]))) {
+				if ((i <= 0) && ( gf(gnode(nodeid)))) {
 					matchcount++;
 //					VERB(VNORM, " ") {
 //						printlstr(word); printf("\n");
@@ -1168,13 +1818,13 @@ DBG(DBG_LOOK, "i=%d, blank=%c nid=%d word=",i, l2c(BB|bl), nodeid) {
 					*mvsndx += 1;
 				}
 				if (i>0)
-					matchcount += bss_lookup(i, word, gc(gaddag[nodeid]), mvs, mvsndx);
+					matchcount += bss_lookup(i, word, gc(gnode(nodeid)), mvs, mvsndx);
 			}
 			word[i] = UBLANK;
 			break;
-		} else if (b & bitset[nodeid]) {
+		} else if (b & gbits(nodeid)) {
 			nodeid = gotol(l, nodeid);
-			if ((i == 0) && ( gf(gaddag[nodeid]))) {
+			if ((i == 0) && ( gf(gnode(nodeid)))) {
 				matchcount++;
 //				VERB(VNORM, " ") {
 //					printlstr(word); printf("\n");
@@ -1183,7 +1833,7 @@ DBG(DBG_LOOK, "i=%d, blank=%c nid=%d word=",i, l2c(BB|bl), nodeid) {
 				*mvsndx += 1;
 				break;
 			}
-			nodeid = gc(gaddag[nodeid]);
+			nodeid = gc(gnode(nodeid));
 		} else {
 			break;
 		}
@@ -1357,9 +2007,9 @@ vprintf(VVERB, "warning[A]: playthru %c(%d) doesn't match played %c(%d)\n", l2c(
 		}
 		ts = lval(l);
 		tts += ts;
-DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gaddag[gotol(l,nid)]), l2c(l));
+DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gnode(gotol(l,nid))), l2c(l));
 		nid = gotol(l, nid);
-		nid = gc(gaddag[nid]);
+		nid = gc(gnode(nid));
 	} while ( (cr > m->row) || (cc > m->col));
 
 	/* we are at first letter in word. nid is with us. */
@@ -1376,9 +2026,9 @@ DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gaddag[gotol(l,nid)]), l2
 			cr = er; cc = ec;
 			sp = &(b->spaces[er][ec]);
 			/* cross the SEP. If no SEP, the mbs is empty. */
-			if (SEPBIT & bitset[nid]) {
+			if (SEPBIT & gbits(nid)) {
 				nid = gotol(SEP, nid);
-				nid = gc(gaddag[nid]);
+				nid = gc(gnode(nid));
 			} else {
 				nid = -1;
 			}
@@ -1408,6 +2058,41 @@ DBG(DBG_MOVE,"at %d,%d dir=%d, mls=%d, mbs=%x (from nid=%d)\n", cr, cc, m->dir,
 	return 1;
 }
 
+/* log space r,c before the move changes it. No log, no work. */
+inline void
+usave(undo_t *u, board_t *b, int r, int c)
+{
+	space_t *sp;
+
+	if (u == NULL) return;
+	ASSERT(u->n < MAXUNDO);
+	sp = &(b->spaces[r][c]);
+	u->s[u->n].r = r;
+	u->s[u->n].c = c;
+	u->s[u->n].b = sp->b;
+	u->s[u->n].mbs[0] = sp->mbs[0];
+	u->s[u->n].mbs[1] = sp->mbs[1];
+	u->n++;
+}
+
+/* take back a makemove8, using its undo log. The rack is not restored. */
+void
+unmakemove(board_t *b, undo_t *u)
+{
+	space_t *sp;
+	int i;
+
+	for (i = u->n - 1; i >= 0; i--) {
+		sp = &(b->spaces[u->s[i].r][u->s[i].c]);
+		sp->b = u->s[i].b;
+		sp->mbs[0] = u->s[i].mbs[0];
+		sp->mbs[1] = u->s[i].mbs[1];
+	}
+	b->hash = u->hash;
+	u->n = 0;
+	ASSERT(b->hash == bdhash(b));
+}
+
 /*
  * we just played letter l on the board, now we need to update the
  * board state info - mls and mbs. which requires some crawling.
@@ -1415,7 +2100,7 @@ DBG(DBG_MOVE,"at %d,%d dir=%d, mls=%d, mbs=%x (from nid=%d)\n", cr, cc, m->dir,
  * note: dir is orthoganol to original move.
  */
 void
-updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
+updatemlsbs(board_t *b, int row, int col, int dir, letter_t l, undo_t *u)
 {
 	int dr = dir;
 	int dc = 1 - dir;
@@ -1439,20 +2124,22 @@ updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
 	ASSERT(pl != '\0');
 	ts = lval(pl);
 	curid = gotol(pl, curid);
-	curid = gc(gaddag[curid]);
+	curid = gc(gnode(curid));
 	cr = aer; cc = aec;
 	while ((pl = ndn(b, cr, cc, dir, -1)) > 0) {
 		ts += lval(pl);
 		ASSERT(curid > 0);
 		curid = gotol(pl, curid);
-		curid = gc(gaddag[curid]);
+		curid = gc(gnode(curid));
 		cr -= dr; cc -= dc;
 	}
 	/* at beginning now. */
 	if (pl == 0) {
 		sp = &(b->spaces[cr][cc]);
 		ASSERT(sp->b.f.letter != '\0');
+		usave(u, b, cr, cc);
 		cr -= dr; cc-=dc;
+		usave(u, b, cr, cc);
 		npl = ndn(b, cr, cc, dir, -1);
 		if (npl <= 0) {
 			sp->b.f.mls[1-dir] = ts;
@@ -1463,6 +2150,11 @@ updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
 			sp->b.f.mls[1-dir] = ts;
 			sp->mbs[1-dir] = finals(curid);
 		} else {
+			/* gap: the cross word joins up with the next one. */
+			sp->b.f.mls[1-dir] = ts;
+			sp = &(b->spaces[cr][cc]);
+			ASSERT(sp->b.f.letter == '\0');
+			sp->b.f.anchor |= (1-dir)+1;
 			sp->b.f.mls[1-dir] = ts + b->spaces[cr-dr][cc-dc].b.f.mls[1-dir];
 			sp->mbs[1-dir] = dobridge2(b, curid, cr, cc, dir, -1);
 		}
@@ -1471,11 +2163,13 @@ updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
 	if (aepl == 0) {
 		sp = &(b->spaces[aer][aec]);
 		ASSERT(sp->b.f.letter != '\0');
+		usave(u, b, aer, aec);
 		aer += dr; aec += dc;
+		usave(u, b, aer, aec);
 		npl = ndn(b, aer, aec, dir, 1);
-		if (SEPBIT & bitset[curid]) {
+		if (SEPBIT & gbits(curid)) {
 			curid = gotol(SEP, curid);
-			curid = gc(gaddag[curid]);
+			curid = gc(gnode(curid));
 		} else {
 			curid = 0;
 		}
@@ -1488,6 +2182,10 @@ updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
 			sp->b.f.mls[1-dir] = ts;
 			sp->mbs[1-dir] = finals(curid);
 		} else {
+			sp->b.f.mls[1-dir] = ts;
+			sp = &(b->spaces[aer][aec]);
+			ASSERT(sp->b.f.letter == '\0');
+			sp->b.f.anchor |= (1-dir)+1;
 			sp->b.f.mls[1-dir] = ts + b->spaces[aer+dr][aec+dc].b.f.mls[1-dir];
 			sp->mbs[1-dir] = dobridge2(b, curid, aer, aec, dir, 1);
 		}
@@ -1498,7 +2196,7 @@ updatemlsbs(board_t *b, int row, int col, int dir, letter_t l)
  * assume playthru. Set mnids.
  */
 int
-makemove8(board_t *b, move_t *m, int playthru, int umbs, rack_t *r)
+makemove8(board_t *b, move_t *m, int playthru, int umbs, rack_t *r, undo_t *u)
 {
 	int ewr, ewc;
 	int curid = 1;
@@ -1515,6 +2213,10 @@ makemove8(board_t *b, move_t *m, int playthru, int umbs, rack_t *r)
 	ewr = m->row + (dr * i);
 	ewc = m->col + (dc * i);
 	ASSERT(playthru);
+	if (u) {
+		u->n = 0;
+		u->hash = b->hash;
+	}
 
 	for (/* i already set */; i >=0; i--)
 	{
@@ -1522,7 +2224,7 @@ makemove8(board_t *b, move_t *m, int playthru, int umbs, rack_t *r)
 		cc = m->col + (dc * i);
 		sp = &(b->spaces[cr][cc]);
 		pl = m->tiles[i];
-		if ((curid <= 0) || (!(l2b(pl) & bitset[curid]))) {
+		if ((curid <= 0) || (!(l2b(pl) & gbits(curid)))) {
 			VERB(VNORM, "not a valid move ") {
 				printmove(m, -1);
 				return -1;
@@ -1534,9 +2236,11 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 				pl = sp->b.f.letter;
 			}
 		} else {
+			usave(u, b, cr, cc);
 			sp->b.f.letter = pl;
 			sp->b.f.anchor = 0;
-			updatemlsbs(b, cr, cc, 1-m->dir, pl);
+			b->hash ^= zboard[cr][cc][pl & 0x3F];
+			updatemlsbs(b, cr, cc, 1-m->dir, pl, u);
 			// updatemls(b, m->dir, cr, cc, lval(pl));
 			// updatembs2(b, m->dir, cr, cc, pl);
 			pluckrack(r, pl);
@@ -1544,7 +2248,7 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 		ts = lval(pl);
 		tts += ts;
 		curid = gotol(pl, curid);
-		curid = gc(gaddag[curid]);
+		curid = gc(gnode(curid));
 	}
 	/* just ran from end of word to beginning */
 	ASSERT((cr == m->row) && (cc == m->col));
@@ -1552,7 +2256,9 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 	ASSERT(npl <= 0);
 	if (npl == 0) {
 		/* a space before word. */
+		usave(u, b, cr, cc);
 		cr -= dr; cc -= dc;
+		usave(u, b, cr, cc);
 		nnpl = ndn(b, cr, cc, m->dir, -1);
 		if (nnpl <= 0) {
 			sp->b.f.mls[1-m->dir] = tts;
@@ -1563,6 +2269,11 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 			sp->b.f.mls[1-m->dir] = tts;
 			sp->mbs[1-m->dir] = finals(curid);
 		} else {
+			/* gap: mbs has to bridge to the word past it. */
+			sp->b.f.mls[1-m->dir] = tts;
+			sp = &(b->spaces[cr][cc]);
+			ASSERT(sp->b.f.letter == '\0');
+			sp->b.f.anchor |= (1-m->dir)+1;
 			sp->b.f.mls[1-m->dir] = tts + b->spaces[cr-dr][cc-dc].b.f.mls[1-m->dir];
 			sp->mbs[1-m->dir] = dobridge2(b, curid, cr, cc, m->dir, -1);
 		}
@@ -1570,11 +2281,15 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 	/* now do the other end. */
 	npl = ndn(b, ewr, ewc, m->dir, 1);
 	if (npl == 0) {
+		/* the last letter keeps the word score, for bridges to it */
+		sp = &(b->spaces[ewr][ewc]);
+		usave(u, b, ewr, ewc);
 		ewr += dr; ewc += dc;
+		usave(u, b, ewr, ewc);
 		nnpl = ndn(b, ewr, ewc, m->dir, 1);
-		if (SEPBIT & bitset[curid]) {
+		if (SEPBIT & gbits(curid)) {
 			curid = gotol(SEP, curid);
-			curid = gc(gaddag[curid]);
+			curid = gc(gnode(curid));
 		} else {
 			curid = 0;
 		}
@@ -1587,10 +2302,15 @@ vprintf(VVERB, "warning[C]: move[%d] %c doesn't match board %c at %d,%d\n", i, l
 			sp->b.f.mls[1-m->dir] = tts;
 			sp->mbs[1-m->dir] = finals(curid);
 		} else {
+			sp->b.f.mls[1-m->dir] = tts;
+			sp = &(b->spaces[ewr][ewc]);
+			ASSERT(sp->b.f.letter == '\0');
+			sp->b.f.anchor |= (1-m->dir)+1;
 			sp->b.f.mls[1-m->dir] = tts + b->spaces[ewr+dr][ewc+dc].b.f.mls[1-m->dir];
 			sp->mbs[1-m->dir] = dobridge2(b, curid, ewr, ewc, m->dir, 1);
 		}
 	}
+	ASSERT(b->hash == bdhash(b));
 	return 1;
 }
 
@@ -1663,9 +2383,9 @@ vprintf(VVERB, "warning[B]: playthru %c(%d) doesn't match played %c(%d)\n", l2c(
 		}
 		ts = lval(l);
 		tts += ts;
-DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gaddag[gotol(l,nid)]), l2c(l));
+DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gnode(gotol(l,nid))), l2c(l));
 		nid = gotol(l, nid);
-		nid = gc(gaddag[nid]);
+		nid = gc(gnode(nid));
 	} while ( (cr > m->row) || (cc > m->col));
 
 	/* we are at first letter in word. nid is with us. */
@@ -1681,9 +2401,9 @@ DBG(DBG_MOVE, "moving from %d to %d via %c\n", nid, gc(gaddag[gotol(l,nid)]), l2
 			cr = er; cc = ec;
 			sp = &(b->spaces[er][ec]);
 			/* cross the SEP. If no SEP, the mbs is empty. */
-			if (SEPBIT & bitset[nid]) {
+			if (SEPBIT & gbits(nid)) {
 				nid = gotol(SEP, nid);
-				nid = gc(gaddag[nid]);
+				nid = gc(gnode(nid));
 			} else {
 				nid = -1;
 			}
@@ -1893,7 +2613,8 @@ showboard(board_t b, int what)
 
 	switch (what) {
 	case B_TILES:
-		printf("Letters on board\n");
+		printf("Letters on board, hash %016llx\n", b.hash);
+		DBG(DBG_MOVE, "full recompute %016llx\n", bdhash(&b));
 		break;
 	case B_HMLS:
 		printf("Horizontal move letter scores\n");
@@ -2133,28 +2854,233 @@ printmove(move_t *m, int rev)
 
 
 /*
- * print out a full position. Use VERB levels.
- * depth, move, score, rack, (bag, bagpos), board
- * stats
+ * -o: the game as it's played, in name.gcg. Written through a big
+ * stdio buffer, so the search doesn't wait on it.
  */
-void
-printpos(position_t P)
+__thread FILE *gcgf = NULL;
+__thread int turns = 0;		// moves played in the game so far
+
+/* start the gcg file. returns 0 if we can't, and there won't be one. */
+int
+gcgopen()
 {
-if (dtrap == 0) {
-	dtrap = 1;
-} 
-	vprintf(VNORM, "position[%d]=%d",  P.depth, P.sc);
-	VERB(VNORM, " move %d of %d ", P.mvndx, P.mvcnt) {
-		printmove(&(P.m), -1);
+	char fn[PATH_MAX];
+
+	if (batchn != 0) {
+		snprintf(fn, sizeof(fn), "%s-%s.gcg", gcgfn, bagname);
+	} else {
+		snprintf(fn, sizeof(fn), "%s.gcg", gcgfn);
 	}
-	VERB(VVERB, "rack=") {
-		printlstr(P.r.tiles);
-		printf(" bag=%c[%d] ",bagtag, P.bagndx);
-		printf("\n");
+	gcgf = fopen(fn, "w");
+	if (gcgf == NULL) {
+		VERB(VNORM, "ERROR: gcg file ") {
+			perror(fn);
+		}
+		return 0;
 	}
-	stprintf(STMED, "%llu moves in %llu nsec: %llu nsec/mv\n", P.stats.moves, P.stats.evtime, P.stats.evtime/P.stats.moves);
-	stprintf(STMED, "max: depth=%d width=%d word score=%d game score=%d\n", P.stats.maxdepth, P.stats.maxwidth, P.stats.wordhs, P.stats.gamehs);
-	VERB(VVERB, "-") {
+	setvbuf(gcgf, NULL, _IOFBF, GCGBUF);
+	fprintf(gcgf, "#character-encoding UTF-8\n");
+	fprintf(gcgf, "#player1 deeper deeper\n");
+	fprintf(gcgf, "#title bag %s\n", bagname);
+	fprintf(gcgf, "#description deeper -T %d -n %d\n", strat, level);
+	return 1;
+}
+
+/*
+ * write position P, and bag, to f as a line of text, or as a posrec_t
+ * and the bag if bin. bag can be NULL. Returns 0, or -1 if f won't take it.
+ */
+int
+possave(FILE *f, position_t *P, bag_t bag, int bin)
+{
+	posrec_t h;
+	letter_t l;
+	int r, c, e, i, n = 0;
+	int blen = (bag == NULL) ? 0 : strlen(bag);
+
+	if (blen > POSBAG) blen = POSBAG;
+	flockfile(f);	/* batch threads share the --corpus file */
+	if (bin) {
+		memset(&h, 0, sizeof(h));
+		h.magic = POSMAGIC;
+		h.version = POSVERSION;
+		h.baglen = blen;
+		h.sc = P->sc;
+		h.bagndx = P->bagndx;
+		for (i = 0; (i < RACKSIZE) && (P->r.tiles[i] != '\0'); i++) {
+			if (P->r.tiles[i] != MARK) h.rack[n++] = P->r.tiles[i];
+		}
+		for (r = 0; r < BOARDX; r++) {
+			for (c = 0; c < BOARDY; c++) {
+				h.tiles[r * BOARDY + c] = P->b.spaces[r][c].b.f.letter;
+			}
+		}
+		if ((fwrite(&h, sizeof(h), 1, f) != 1) ||
+		    ((blen > 0) && (fwrite(bag, blen, 1, f) != 1))) {
+			n = -1;
+		}
+		funlockfile(f);
+		return (n < 0) ? -1 : 0;
+	}
+	for (r = 0; r < BOARDX; r++) {
+		e = 0;
+		for (c = 0; c < BOARDY; c++) {
+			l = P->b.spaces[r][c].b.f.letter;
+			if (l == '\0') {
+				e++;
+				continue;
+			}
+			if (e > 0) fprintf(f, "%d", e);
+			e = 0;
+			putc(l2c(l), f);	/* blanks come out lowercase */
+		}
+		if (e > 0) fprintf(f, "%d", e);
+		if (r < BOARDX - 1) putc('/', f);
+	}
+	putc(' ', f);
+	for (i = 0; (i < RACKSIZE) && (P->r.tiles[i] != '\0'); i++) {
+		if (P->r.tiles[i] != MARK) {
+			putc(l2c(P->r.tiles[i]), f);
+			n++;
+		}
+	}
+	fprintf(f, "%s %d %d ", (n == 0) ? "-" : "", P->bagndx, P->sc);
+	for (i = 0; i < blen; i++) putc(l2c(bag[i]), f);
+	n = fprintf(f, "%s\n", (blen == 0) ? "-" : "");
+	funlockfile(f);
+	return (n < 0) ? -1 : 0;
+}
+
+/*
+ * write move m, and the total it brings. b is the board before it,
+ * r and bagndx the rack and bag before it was refilled for it, as
+ * they are kept between turns. Letters already on b are '.'.
+ * Every strategy comes through here, so it counts the turns too.
+ */
+void
+gcgmove(board_t *b, rack_t *r, int bagndx, move_t *m, int total)
+{
+	rack_t tr = *r;
+	position_t Q;
+	char rs[RACKSIZE+1];
+	char ws[BOARDSIZE+1];
+	int i, n = 0, row = m->row, col = m->col;
+
+	if (m->tiles[0] == '\0') return;
+	turns++;
+	if ((benchmvs != NULL) && (benchnmv < BENCHMVS)) {
+		benchmvs[benchnmv].b = *b;
+		benchmvs[benchnmv].r = *r;
+		fillrack(&(benchmvs[benchnmv].r), globalbag, &bagndx);
+		benchmvs[benchnmv++].m = *m;
+	}
+	if ((gcgf == NULL) && (corpf == NULL)) return;
+	fillrack(&tr, globalbag, &bagndx);
+	qsort(tr.tiles, strlen(tr.tiles), 1, lcmp);
+	for (i = 0; (i < RACKSIZE) && (tr.tiles[i] != '\0'); i++) {
+		if (tr.tiles[i] != MARK) rs[n++] = l2c(tr.tiles[i]);
+	}
+	rs[n] = '\0';
+	if (corpf != NULL) {
+		Q.b = *b;
+		Q.r = tr;
+		Q.bagndx = bagndx;
+		Q.sc = total - m->score;
+		if (possave(corpf, &Q, globalbag, corpbin) < 0) {
+			VERB(VNORM, "ERROR: corpus ") {
+				perror(corpfn);
+			}
+		}
+	}
+	if (gcgf == NULL) return;
+	for (i = 0; m->tiles[i] != '\0'; i++) {
+		if (b->spaces[row][col].b.f.letter != '\0') {
+			ws[i] = '.';
+		} else {
+			ws[i] = l2c(m->tiles[i]);
+		}
+		row += m->dir; col += 1 - m->dir;
+	}
+	ws[i] = '\0';
+	if (m->dir == M_HORIZ) {
+		fprintf(gcgf, ">deeper: %s %d%c %s +%d %d\n", rs, m->row+1, coltags[m->col], ws, m->score, total);
+	} else {
+		fprintf(gcgf, ">deeper: %s %c%d %s +%d %d\n", rs, coltags[m->col], m->row+1, ws, m->score, total);
+	}
+}
+
+/* end of game: what was left cost pen. */
+void
+gcgend(rack_t *r, int pen, int total)
+{
+	char rs[RACKSIZE+1];
+
+	if ((gcgf == NULL) || (pen == 0)) return;
+	l2cstr(r->tiles, rs);
+	fprintf(gcgf, ">deeper: %s (%s) -%d %d\n", rs, rs, pen, total);
+}
+
+/* write out each move of the line from P0 to P and on down P->next. */
+void
+gcgline(position_t *P0, position_t *P)
+{
+	position_t *pP = P0;
+
+	for (; P != NULL; pP = P, P = P->next) {
+		gcgmove(&(pP->b), &(pP->r), pP->bagndx, &(P->m), P->sc);
+	}
+}
+
+void
+gcgclose()
+{
+	if (gcgf == NULL) return;
+	if (fclose(gcgf) != 0) {
+		VERB(VNORM, "ERROR: gcg file ") {
+			perror(gcgfn);
+		}
+	}
+	gcgf = NULL;
+}
+
+/*
+ * print out a full position. Use VERB levels.
+ * depth, move, score, rack, (bag, bagpos), board
+ * stats
+ */
+void
+printpos(position_t P)
+{
+if (dtrap == 0) {
+	dtrap = 1;
+} 
+	vprintf(VNORM, "position[%d]=%d",  P.depth, P.sc);
+	VERB(VNORM, " move %d of %d ", P.mvndx, P.mvcnt) {
+		printmove(&(P.m), -1);
+	}
+	VERB(VVERB, "rack=") {
+		printlstr(P.r.tiles);
+		printf(" bag=%c[%d] ",bagtag, P.bagndx);
+		printf(" hash=%016llx", P.b.hash);
+		printf("\n");
+	}
+#ifdef DEBUG
+	if (P.b.hash != bdhash(&(P.b))) {
+		vprintf(VNORM, "hash mismatch: kept %016llx, recomputed %016llx\n", P.b.hash, bdhash(&(P.b)));
+	}
+#endif
+	stprintf(STMED, "%llu moves in %llu nsec: %llu nsec/mv\n", P.stats.moves, P.stats.evtime, P.stats.evtime/P.stats.moves);
+	stprintf(STMED, "max: depth=%d width=%d word score=%d game score=%d\n", P.stats.maxdepth, P.stats.maxwidth, P.stats.wordhs, P.stats.gamehs);
+	if (nthreads > 1) {
+		stprintf(STMED, "pool: %llu steals, %llu idle\n", P.stats.steals, P.stats.idles);
+	}
+	if (ttab) {
+		stprintf(STMED, "table: %llu hits, %llu misses\n", P.stats.tthits, P.stats.ttmisses);
+	}
+	if (prune) {
+		stprintf(STMED, "pruned: %llu leaves\n", P.stats.cuts);
+	}
+	VERB(VVERB, "-") {
 		showboard(P.b, B_TILES);
 	}
 	VERB(VNOISY, "-") {
@@ -2173,7 +3099,151 @@ if (dtrap == 0) {
  * other few items are stack items.
  */
 
-#define MAXMVS	(16*1024)/* mvs array. expand as needed. */
+#define MAXMVS	(16*1024)/* mvs array to start with. grows as needed. */
+#define MVSTACK	256	/* move buffers in use at once, per thread */
+
+/*
+ * move buffers: a stack per thread. Each genall caller takes the next
+ * one and gives it back when done with its moves, so recursion and
+ * helping with other threads' work nest without sharing.
+ */
+__thread mvbuf_t mvstack[MVSTACK];
+__thread int mvtop = 0;
+
+mvbuf_t *
+mvpush()
+{
+	mvbuf_t *mb;
+
+	if (mvtop >= MVSTACK) {
+		vprintf(VNORM, "ERROR: move buffers nested too deep\n");
+		return NULL;
+	}
+	mb = &(mvstack[mvtop]);
+	if (mb->mvs == NULL) {
+		mb->mvs = (cmove_t *)malloc( sizeof(cmove_t) * MAXMVS);
+		if (mb->mvs == NULL) {
+			vprintf(VNORM, "ERROR: failed allocate moves array\n");
+			return NULL;
+		}
+		mb->size = MAXMVS;
+	}
+	mb->keep = MV_ALL;
+	mb->ank = 0;
+	mb->floor = -1;
+	mvtop++;
+	return mb;
+}
+
+void
+mvpop(mvbuf_t *mb)
+{
+	if (mb == NULL) return;
+	ASSERT(mb == &(mvstack[mvtop-1]));
+	mvtop--;
+}
+
+/* double the buffer. returns 0 if we can't. */
+int
+mvgrow(mvbuf_t *mb)
+{
+	cmove_t *nmvs;
+
+	nmvs = (cmove_t *)realloc(mb->mvs, sizeof(cmove_t) * mb->size * 2);
+	if (nmvs == NULL) {
+		vprintf(VNORM, "ERROR: failed to grow moves array past %d\n", mb->size);
+		return 0;
+	}
+	mb->mvs = nmvs;
+	mb->size *= 2;
+	return 1;
+}
+
+/* is there room for move n? */
+inline int
+mvroom(mvbuf_t *mb, int n)
+{
+	if (n < mb->size) return 1;
+	return mvgrow(mb);
+}
+
+/* pack generated move m for a move list. Tiles already on b are dropped. */
+inline cmove_t
+packmove(board_t *b, move_t *m)
+{
+	cmove_t cm;
+	int i, n = 0;
+	int r = m->row, c = m->col;
+
+	ASSERT(m->score <= CM_MAXSCORE);
+	cm = ((cmove_t)m->score << 51) | ((cmove_t)(r * BOARDSIZE + c) << 43) |
+	    ((cmove_t)m->dir << 42);
+	for (i = 0; m->tiles[i] != '\0'; i++) {
+		if (b->spaces[r][c].b.f.letter == '\0') {
+			ASSERT(n < RACKSIZE);
+			cm |= (cmove_t)deblank(m->tiles[i]) << (5 * n);
+			if (m->tiles[i] & BB) cm |= (cmove_t)1 << (35 + n);
+			n++;
+		}
+		r += m->dir; c += 1 - m->dir;
+	}
+	return cm;
+}
+
+/*
+ * full move from a packed one, on the board it was generated for:
+ * rack tiles in the empty squares, board letters in between and after.
+ */
+void
+unpackmove(board_t *b, cmove_t cm, move_t *m)
+{
+	int i = 0, n = 0;
+	int r, c;
+	letter_t l;
+
+	*m = emptymove;
+	m->score = CM_SCORE(cm);
+	m->dir = CM_DIR(cm);
+	m->row = r = CM_SQ(cm) / BOARDSIZE;
+	m->col = c = CM_SQ(cm) % BOARDSIZE;
+	while ((r < BOARDSIZE) && (c < BOARDSIZE)) {
+		l = b->spaces[r][c].b.f.letter;
+		if (l == '\0') {
+			if ((n >= RACKSIZE) || ((l = CM_TILE(cm, n)) == '\0')) break;
+			if (CM_BLANK(cm, n)) l |= BB;
+			n++;
+		}
+		m->tiles[i++] = l;
+		r += m->dir; c += 1 - m->dir;
+	}
+}
+
+/* record move m in the list, packed. 0 if there's no room. */
+inline int
+addmove(mvbuf_t *mb, int *mvsndx, board_t *b, move_t *m)
+{
+	if (mb->keep == MV_BEST) {
+		/* first best in board order, as veep_b would pick it */
+		if ((*mvsndx > 0) && ((m->score < CM_SCORE(mb->mvs[0])) ||
+		    ((m->score == CM_SCORE(mb->mvs[0])) && (mb->ank >= mb->bestank)))) {
+			return 1;
+		}
+		*mvsndx = 0;
+		mb->bestank = mb->ank;
+	}
+	if (!mvroom(mb, *mvsndx)) return 0;
+	mb->mvs[*mvsndx] = packmove(b, m);
+#ifdef DEBUG
+	{
+		move_t um;
+		unpackmove(b, mb->mvs[*mvsndx], &um);
+		ASSERT(strcmp(um.tiles, m->tiles) == 0);
+		ASSERT((um.row == m->row) && (um.col == m->col));
+	}
+#endif
+	*mvsndx += 1;
+	return 1;
+}
 
 
 inline void
@@ -2217,9 +3287,10 @@ typedef struct _gat_d {
  * played is 0, nodeid is 1...
  */
 int
-genallat_d(position_t *P, move_t *mvs, int *mvsndx, const gatd_t gat)
+genallat_d(position_t *P, mvbuf_t *mb, int *mvsndx, const gatd_t gat)
 {
 	board_t *b = &(P->b);
+	move_t tm;
 	gatd_t newgat = gat;
 
 	int movecnt = 0;
@@ -2234,6 +3305,7 @@ genallat_d(position_t *P, move_t *mvs, int *mvsndx, const gatd_t gat)
 	bs_t bs;
 	bs_t bbs;
 	letter_t bl = 0;
+	int stop;
 
 	/* sanity checks. add more later. */
 	ASSERT(gat.nodeid > 0);
@@ -2256,7 +3328,21 @@ DBG(DBG_GEN, "[%d] at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d", gat.ndx,
 		cc = &newgat.ewc;
 	}
 	pl = ndn(b, *cr, *cc, gat.m.dir, gat.ndx == 0 ? 0 : gat.side);
-	if (pl < 0) return  movecnt;
+	if (pl < 0) {
+		/* hit the wall going left: all we can do is turn around. */
+		if ((gat.side < 0) && (gat.played > 0) &&
+		    (gbits(gat.nodeid) & SEPBIT) &&
+		    (ndn(b, gat.ewr, gat.ewc, gat.m.dir, 1) >= 0)) {
+			newgat.m.tiles[newgat.ndx] = 0;
+			newgat.side = 1;
+			curid = gotol(SEP, gat.nodeid);
+			newgat.nodeid = gc(gnode(curid));
+			revstr(newgat.m.tiles);
+			ASSERT(newgat.nodeid > 0);
+			movecnt += genallat_d(P, mb, mvsndx, newgat);
+		}
+		return movecnt;
+	}
 	if (gat.ndx > 0) {
 		*cc += (1 - gat.m.dir) * gat.side;
 		*cr += (gat.m.dir) * gat.side;
@@ -2266,13 +3352,14 @@ DBG(DBG_GEN, "[%d] at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d", gat.ndx,
 		letter_t npl;
 		int change = 0;
 		while (pl > 0) {
-			if (!(bitset[newgat.nodeid] & l2b(pl))) {
+			if (!(gbits(newgat.nodeid) & l2b(pl))) {
 				return movecnt;
 			}
 			newgat.nodeid = gotol(pl, newgat.nodeid);
 			if (pl != SEP) {
 				newgat.m.tiles[newgat.ndx++] = pl;
 				newgat.sct.ttl_ts += lval(pl);
+				newgat.sct.ttl_tbs += lval(pl);
 			} else {
 				revnstr(newgat.m.tiles, newgat.ndx);
 			}
@@ -2288,34 +3375,33 @@ DBG(DBG_GEN, "[%d] at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d", gat.ndx,
 				if (npl <= 0) break;
 				pl = npl;
 			}
-			newgat.nodeid = gc(gaddag[newgat.nodeid]);
+			newgat.nodeid = gc(gnode(newgat.nodeid));
 			if (pl != SEP) {
 				*cc += (1 - newgat.m.dir) * newgat.side;
 				*cr += (newgat.m.dir) * newgat.side;
 			}
 		}
-		newgat.sct.ttl_tbs = newgat.sct.ttl_ts;
 		ASSERT((((pl > 0) && (newgat.nodeid > 0))));
-		if (gf(gaddag[newgat.nodeid]) && (newgat.played > 0)) {
+		if (gf(gnode(newgat.nodeid)) && (newgat.played > 0)) {
 			newgat.m.score = finalscore(newgat.sct);
 			newgat.m.row = newgat.swr; newgat.m.col = newgat.swc;
 			VERB(VNOISY, "at_d:") {
 				printmove(&(newgat.m), -1);
 			}
 			/* record play */
-			ASSERT(*mvsndx < MAXMVS);
-			mvs[*mvsndx] = newgat.m;
+			tm = newgat.m;
 			if (newgat.side < 0) {
-				revstr(mvs[*mvsndx].tiles);
+				revstr(tm.tiles);
 			}
-			*mvsndx += 1; movecnt++; gmcnt++;
+			if (!addmove(mb, mvsndx, b, &tm)) return movecnt;
+			movecnt++; gmcnt++;
 		}
 		pl = npl;
 		/* another special case: we hit the wall. */
 		if (pl < 0) {
 			newgat.side = 1;
 		}
-		newgat.nodeid = gc(gaddag[newgat.nodeid]);
+		newgat.nodeid = gc(gnode(newgat.nodeid));
 		*cc += (1 - newgat.m.dir) * newgat.side;;
 		*cr += (newgat.m.dir) * newgat.side;
 		if ((pl < 0) || (newgat.nodeid <= 0)) {
@@ -2324,15 +3410,16 @@ DBG(DBG_GEN, "[%d] at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d", gat.ndx,
 		}
 	}
 	ASSERT((pl == 0) && (newgat.nodeid > 0));
-	/* prune */
-	if ((gat.side < 0) && (gat.played > 0) &&
-	    b->spaces[*cr][*cc].b.f.anchor) {
-		return movecnt;
-	}
+	/*
+	 * prune: going left into another anchor, which makes those moves
+	 * itself. We can still turn around here, though.
+	 */
+	stop = (gat.side < 0) && (gat.played > 0) &&
+	    b->spaces[*cr][*cc].b.f.anchor;
 	/* iterate over playable tiles */
 	saveid = newgat.nodeid;
 	curid = newgat.nodeid;
-	bbs = bitset[curid];
+	bbs = gbits(curid);
 	sct = newgat.sct;
 	sct.play = 1;
 	sct.wm = b->spaces[*cr][*cc].b.f.wm;
@@ -2350,6 +3437,11 @@ DBG(DBG_GEN, "[%d] at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d", gat.ndx,
 	if ((newgat.side < 0) && (newgat.played <= 0) && (newgat.presep)) {
 		ASSERT(b->spaces[*cr][*cc].b.f.anchor);
 		newgat.presep = 0;
+		bbs = gbits(curid);
+		goto seponly;
+	}
+	if (stop) {
+		bbs = gbits(curid);
 		goto seponly;
 	}
 	newgat.m.tiles[newgat.ndx+1] = '\0';
@@ -2361,29 +3453,29 @@ onceagain:
 		newgat.played = gat.played+1;
 		newgat.m.tiles[newgat.ndx] = pl | bl;
 		newgat.sct = sct;
-		newgat.sct.ts = lval(pl);
+		newgat.sct.ts = lval(pl | bl);	/* blanks are worth 0 */
 		newgat.sct.tbs *= newgat.sct.ts;/* saved multiplier */
 		updatescore(&(newgat.sct));
-		if (gf(gaddag[curid]) && (npl <= 0)) {
+		if (gf(gnode(curid)) && (npl <= 0)) {
 			newgat.m.score = finalscore(newgat.sct);
 			newgat.m.row = newgat.swr; newgat.m.col = newgat.swc;
 			VERB(VNOISY, "at_d: ") {
 				printmove(&(newgat.m), newgat.side < 0 ? 0 : -1);
 			}
-			ASSERT(*mvsndx < MAXMVS);
-			mvs[*mvsndx] = newgat.m;
+			tm = newgat.m;
 			if (newgat.side < 0) {
-				revstr(mvs[*mvsndx].tiles);
+				revstr(tm.tiles);
 			}
-			*mvsndx += 1; movecnt++; gmcnt++;
+			if (!addmove(mb, mvsndx, b, &tm)) return movecnt;
+			movecnt++; gmcnt++;
 		}
 		if (!bl) rackem(&(gat.r), &(newgat.r), &(newgat.rbs), pl);
-		newgat.nodeid = gc(gaddag[curid]);
+		newgat.nodeid = gc(gnode(curid));
 		if (newgat.nodeid > 0) {
 			newgat.ndx++;
 
 DBG(DBG_GEN, "[%d] recurse at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d\n", newgat.ndx, newgat.swr, newgat.swc, newgat.m.dir, newgat.ewr, newgat.ewc, newgat.side, newgat.nodeid, newgat.rbs, newgat.played);
-			movecnt += genallat_d(P, mvs, mvsndx, newgat);
+			movecnt += genallat_d(P, mb, mvsndx, newgat);
 			newgat.ndx--;
 		}
 	}
@@ -2400,12 +3492,12 @@ DBG(DBG_GEN, "[%d] recurse at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d\n"
 	}
 seponly:
 	/* and do SEP if needed */
-	if ((newgat.side < 0) && (bbs & SEPBIT) && (newgat.played > 0)) {
+	if ((newgat.side < 0) && (bbs & SEPBIT) && ((newgat.played > 0) || gat.presep)) {
 		npl = ndn(b, newgat.ewr, newgat.ewc, newgat.m.dir, 1);
 		if (npl >= 0) {
 			newgat.sct = sct;
 			newgat.m.tiles[newgat.ndx] = 0;
-			newgat.played--;
+			newgat.played = gat.played;
 			newgat.r = gat.r;
 			newgat.rbs = gat.rbs;
 			newgat.swr += newgat.m.dir;
@@ -2414,12 +3506,12 @@ seponly:
 //			newgat.ewr += newgat.m.dir;
 //			newgat.ewc += (1 - newgat.m.dir);
 			curid = gotol(SEP, saveid);
-			newgat.nodeid = gc(gaddag[curid]);
+			newgat.nodeid = gc(gnode(curid));
 			revstr(newgat.m.tiles);
 			ASSERT(newgat.nodeid > 0);
 
 DBG(DBG_GEN, "[%d] recurse B at %d,%d/%d to %d,%d (%d) node=%d rbs=%x played=%d\n", newgat.ndx, newgat.swr, newgat.swc, newgat.m.dir, newgat.ewr, newgat.ewc, newgat.side, newgat.nodeid, newgat.rbs, newgat.played);
-			movecnt += genallat_d(P, mvs, mvsndx, newgat);
+			movecnt += genallat_d(P, mb, mvsndx, newgat);
 		}
 	}
 
@@ -2428,7 +3520,7 @@ DBG(DBG_GEN, "[%d] pop %d moves\n", newgat.ndx, movecnt);
 }
 
 int
-pregen_d(position_t *P, move_t *mvs, int *mvsndx)
+pregen_d(position_t *P, mvbuf_t *mb, int *mvsndx)
 {
 	board_t *b = &(P->b);
 	move_t *m = &(P->m);
@@ -2479,60 +3571,316 @@ DBG(DBG_GEN, "at %d,%d dir=%d", ar,ac, m->dir) {
 		}
 		gogat.swr = gogat.ewr; gogat.swc = gogat.ewc;
 	}
-	return genallat_d(P, mvs, mvsndx, gogat);
+	return genallat_d(P, mb, mvsndx, gogat);
 }
 
 
+/* the rack, as anchorbound sees it: psum[k] is its k best tile values. */
+typedef struct Rackval {
+	int n;			/* tiles */
+	letter_t *tiles;	/* which are */
+	bs_t rbs;		/* and as a bitset */
+	int psum[RACKSIZE+1];
+} rackval_t;
+
+void
+rackval(rack_t *r, rackval_t *rv)
+{
+	int v[RACKSIZE];
+	int i, j, t;
+
+	rv->n = strlen(r->tiles);
+	rv->tiles = r->tiles;
+	rv->rbs = lstr2bs(r->tiles);
+	for (i = 0; i < rv->n; i++) {
+		t = lval(r->tiles[i]);
+		for (j = i; (j > 0) && (v[j-1] < t); j--) {
+			v[j] = v[j-1];
+		}
+		v[j] = t;
+	}
+	rv->psum[0] = 0;
+	for (i = 0; i < rv->n; i++) {
+		rv->psum[i+1] = rv->psum[i] + v[i];
+	}
+}
+
+/*
+ * best rack tile that can go on empty square sp in a dir move, or -1
+ * if none can: the cross word there has to take it. Blanks count 0.
+ */
 int
-genall_d(position_t *P, move_t **mvs, int *mvsndx)
+sqvmax(space_t *sp, int dir, rackval_t *rv)
 {
-	int r, c, dir, moves = 0;
-	bs_t rbs;
+	bs_t ok = ALLPHABITS;
+	int i, v, vmax = -1;
+
+	if (sp->b.f.anchor & (dir + 1)) {
+		ok = sp->mbs[dir] & ALLPHABITS;
+	}
+	if ((rv->rbs & UBLBIT) && ok) vmax = 0;
+	if (!(rv->rbs & ok)) return vmax;
+	for (i = 0; i < rv->n; i++) {
+		if (l2b(rv->tiles[i]) & ok) {
+			v = lval(rv->tiles[i]);
+			if (v > vmax) vmax = v;
+		}
+	}
+	return vmax;
+}
 
-	if (*mvs == NULL) {
-		*mvs = (move_t *)malloc( sizeof(move_t) * MAXMVS);
-		if (*mvs == NULL) {
-			vprintf(VNORM, "ERROR: failed allocate moves array\n");
-			return 0;
+/*
+ * walk out from r,c (not counting it) by dr,dc, up to max empty
+ * squares, or one no tile can go on. e[k] is the k'th empty, vm[k]
+ * the best tile for it, lt[k] the board letters just before it, lt[n]
+ * the ones past the last. Returns n.
+ */
+int
+boundside(board_t *b, int r, int c, int dir, int side, int max, rackval_t *rv,
+    space_t **e, int *vm, int *lt)
+{
+	int dr = dir * side, dc = (1 - dir) * side;
+	int n = 0;
+	space_t *sp;
+
+	lt[0] = 0;
+	r += dr; c += dc;
+	while ((r >= 0) && (r < BOARDSIZE) && (c >= 0) && (c < BOARDSIZE)) {
+		sp = &(b->spaces[r][c]);
+		if (sp->b.f.letter != '\0') {
+			lt[n] += lval(sp->b.f.letter);
+		} else {
+			if (n == max) break;
+			if ((vm[n] = sqvmax(sp, dir, rv)) < 0) break;
+			e[n++] = sp;
+			lt[n] = 0;
+		}
+		r += dr; c += dc;
+	}
+	return n;
+}
+
+/* running totals over the empty squares a move would cover. */
+typedef struct Wtally {
+	int n;			/* squares */
+	int n3, n2;		/* with 3x and 2x letter */
+	int wm;			/* product of word multipliers */
+	int lt;			/* board letters played through */
+	int xs;			/* most the cross words could be */
+} wtally_t;
+
+inline void
+tally(wtally_t *w, space_t *sp, int dir, int vmax)
+{
+	/* vmax: best tile that fits here */
+	w->n++;
+	if (sp->b.f.lm == 3) w->n3++;
+	if (sp->b.f.lm == 2) w->n2++;
+	w->wm *= sp->b.f.wm;
+	if (sp->b.f.anchor & (dir + 1)) {
+		w->xs += sp->b.f.wm * (sp->b.f.mls[dir] + vmax * sp->b.f.lm);
+	}
+}
+
+/* most the run tallied in w can score, with lt more board letters after it. */
+inline int
+wscore(wtally_t *w, rackval_t *rv, int lt)
+{
+	int k3, k2, sc;
+
+	/* best tiles on the best letter multipliers */
+	k3 = (w->n3 < w->n) ? w->n3 : w->n;
+	k2 = (w->n3 + w->n2 < w->n) ? w->n3 + w->n2 : w->n;
+	sc = 3 * rv->psum[k3] + 2 * (rv->psum[k2] - rv->psum[k3]) +
+	    (rv->psum[w->n] - rv->psum[k2]);
+	sc = (sc + w->lt + lt) * w->wm + w->xs;
+	if (w->n >= RACKSIZE) sc += BINGOBONUS;
+	return sc;
+}
+
+/*
+ * most any move made from anchor r,c in direction dir can score. A
+ * move fills every empty square from its first to its last, so try
+ * each run of up to rv->n empties that the rack can fill and that
+ * includes the anchor, or starts on the letters just after it (those
+ * moves are made from this anchor too). All the word multipliers in
+ * the run count, plus the board letters in and next to it, its cross
+ * words and the bingo.
+ */
+int
+anchorbound(board_t *b, int r, int c, int dir, rackval_t *rv)
+{
+	space_t *be[RACKSIZE+1], *fe[RACKSIZE+1];
+	int bvm[RACKSIZE+1], fvm[RACKSIZE+1];
+	int blt[RACKSIZE+2], flt[RACKSIZE+2];
+	int nb, nf, i, j, sc, vm;
+	int nr = r + dir, nc = c + 1 - dir;
+	int bound = 0;
+	wtally_t bw, w;
+
+	if (rv->n == 0) return 0;
+	nf = boundside(b, r, c, dir, 1, rv->n, rv, fe, fvm, flt);
+	bw.n = 0; bw.n3 = 0; bw.n2 = 0; bw.wm = 1; bw.lt = 0; bw.xs = 0;
+	if ((nr < BOARDSIZE) && (nc < BOARDSIZE) && (b->spaces[nr][nc].b.f.letter != '\0')) {
+		w = bw;
+		w.lt = flt[0];
+		for (j = 1; j <= nf; j++) {
+			tally(&w, fe[j-1], dir, fvm[j-1]);
+			if (w.n > rv->n) break;
+			sc = wscore(&w, rv, flt[j]);
+			if (sc > bound) bound = sc;
+			w.lt += flt[j];
+		}
+	}
+	if ((vm = sqvmax(&(b->spaces[r][c]), dir, rv)) < 0) return bound;
+	nb = boundside(b, r, c, dir, -1, rv->n - 1, rv, be, bvm, blt);
+	tally(&bw, &(b->spaces[r][c]), dir, vm);
+	for (i = 0; i <= nb; i++) {
+		if (i > 0) {
+			tally(&bw, be[i-1], dir, bvm[i-1]);
+			bw.lt += blt[i-1];
+		}
+		w = bw;
+		w.lt += blt[i];
+		for (j = 0; j <= nf; j++) {
+			if (j > 0) {
+				tally(&w, fe[j-1], dir, fvm[j-1]);
+				if (w.n > rv->n) break;
+			}
+			sc = wscore(&w, rv, flt[j]);
+			if (sc > bound) bound = sc;
+			w.lt += flt[j];
 		}
 	}
-	bzero(*mvs, sizeof(move_t)*MAXMVS);
+	return bound;
+}
+
+/* sort anchors best bound first, board order among equals. */
+int
+ankcmp(const void *a, const void *b)
+{
+	uint64_t ka = *(const uint64_t *)a;
+	uint64_t kb = *(const uint64_t *)b;
+
+	return (ka < kb) ? 1 : ((ka > kb) ? -1 : 0);
+}
+
+/*
+ * all the moves from P, into mb. For a MV_BEST list the anchors are
+ * visited best bound first, and we stop when the bound can't beat what
+ * we have. Ties go to the earlier anchor in board order, so it's the
+ * same move the full list would give veep_b. Anchors that can't beat
+ * mb->floor either are skipped too, and counted in mb->cut.
+ * The bounds are loose: the best one averages ~5x the best move, so
+ * about half the anchors still get searched (-T 3 -s reports it), and
+ * greedy is only 1.2-1.4x faster than with the full list. Doing better
+ * would take a bound inside genallat_d.
+ */
+int
+genall_d(position_t *P, mvbuf_t *mb, int *mvsndx)
+{
+	int r, c, dir, moves = 0;
+	bs_t rbs;
+	rackval_t rv;
+	uint64_t ank[2 * BOARDSIZE * BOARDSIZE];
+	int i, na = 0, ndx, bound;
+	hrtime_t fore = 0;
+#ifdef DEBUG
+	int n0;
+#endif
+
 	*mvsndx = 0;
+	if (mb == NULL) return 0;
+	mb->ank = 0;
+	mb->cut = 0;
+	mb->nank = 0;
+	mb->nsearch = 0;
+	if (benching) fore = gethrtime();
 	rbs = lstr2bs(P->r.tiles);
+	rackval(&(P->r), &rv);
 
 	if (P->sc == -1) {
 		P->sc = 0;
 		P->m.row = STARTR; P->m.col = STARTC; P->m.dir = M_HORIZ;
-		moves = pregen_d(P, *mvs, mvsndx);
+		moves = pregen_d(P, mb, mvsndx);
 DBG(DBG_GEN, "genall made %d start moves\n", moves);
-		return moves;
+		goto out;
 	}
 
 	P->m = emptymove;	
 
+	if (mb->keep == MV_BEST) {
+		for (dir = 0; dir < 2; dir++) {
+			for (r = 0; r < BOARDY; r++) {
+				for (c = 0; c < BOARDX; c++) {
+					if (!P->b.spaces[r][c].b.f.anchor) continue;
+					bound = anchorbound(&(P->b), r, c, dir, &rv);
+					ndx = (dir * BOARDSIZE + r) * BOARDSIZE + c;
+					ank[na++] = ((uint64_t)bound << 16) | (0xFFFF - ndx);
+				}
+			}
+		}
+		qsort(ank, na, sizeof(uint64_t), ankcmp);
+		for (i = 0; i < na; i++) {
+			bound = ank[i] >> 16;
+			ndx = 0xFFFF - (ank[i] & 0xFFFF);
+			if (bound <= mb->floor) {
+				mb->cut = na - i;
+				break;
+			}
+			if (*mvsndx > 0) {
+				if (bound < CM_SCORE(mb->mvs[0])) break;
+				if ((bound == CM_SCORE(mb->mvs[0])) && (ndx > mb->bestank)) continue;
+			}
+			mb->ank = ndx;
+			mb->nsearch++;
+			P->m.dir = ndx / (BOARDSIZE * BOARDSIZE);
+			P->m.row = (ndx / BOARDSIZE) % BOARDSIZE;
+			P->m.col = ndx % BOARDSIZE;
+			moves += pregen_d(P, mb, mvsndx);
+		}
+		mb->nank = na;
+DBG(DBG_GEN, "genall made %d moves from %d of %d anchors\n", moves, i, na);
+		goto out;
+	}
+
 	for (dir = 0; dir < 2; dir++) {
 		for (r = 0; r < BOARDY; r++) {
 			for (c = 0; c < BOARDX; c++) {
-				if (P->b.spaces[r][c].b.f.anchor) {
-					P->m.row = r; P->m.col = c;
-					P->m.dir = dir;
-					moves += pregen_d(P, *mvs, mvsndx);
+				if (!P->b.spaces[r][c].b.f.anchor) continue;
+				P->m.row = r; P->m.col = c;
+				P->m.dir = dir;
+#ifdef DEBUG
+				n0 = *mvsndx;
+#endif
+				moves += pregen_d(P, mb, mvsndx);
+#ifdef DEBUG
+				/* the bound has to hold for every move it made */
+				bound = anchorbound(&(P->b), r, c, dir, &rv);
+				for (i = n0; i < *mvsndx; i++) {
+					ASSERT(CM_SCORE(mb->mvs[i]) <= bound);
 				}
+#endif
 			}
 		}
 	}
 	ASSERT(moves == *mvsndx);
 DBG(DBG_GEN, "genall made %d total moves (%d mvs)\n", moves, *mvsndx);
+out:
+	if (benching) {
+		bgtime += gethrtime() - fore;
+		bgens++;
+		bgmoves += moves;
+	}
 	return moves;
 }
 
 
-
 /* try pre handler function again. move anchor in some cases. */
 /* try using _b. */
 /* non-recursive part.  take care of played tiles first */
 int
-genallat_c(position_t *P, move_t *mvs, int *mvsndx)
+genallat_c(position_t *P, mvbuf_t *mb, int *mvsndx)
 {
 	board_t *b = &(P->b);
 	move_t *m = &(P->m);
@@ -2563,14 +3911,14 @@ DBG(DBG_GEN, "new genallat %d,%d dir=%d", ar,ac, m->dir) {
 			pl = b->spaces[m->row][m->col].b.f.letter;
 			m->tiles[i] = pl; i++;
 			nodeid = gotol(deblank(pl), nodeid);
-			nodeid = gc(gaddag[nodeid]);
+			nodeid = gc(gnode(nodeid));
 			sct.ttl_ts += lval(pl);
 		}
 		sct.ttl_tbs = sct.ttl_ts;
 		/* in this case, we have to change direction. */
-		if (bitset[nodeid] & SEPBIT) {
+		if (gbits(nodeid) & SEPBIT) {
 			nodeid = gotol(SEP, nodeid);
-			nodeid = gc(gaddag[nodeid]);
+			nodeid = gc(gnode(nodeid));
 		} else {
 			/* no valid move here. */
 			for (; i>=0;i--) m->tiles[i]='\0';
@@ -2578,7 +3926,7 @@ DBG(DBG_GEN, "new genallat %d,%d dir=%d", ar,ac, m->dir) {
 		}
 		/* now call our recursive part. */
 DBG(DBG_GEN, "rcall A pos=%d depth=%d rbs=%x\n", i, i, rbs);
-		mvcnt = genallat_b(P, mvs, mvsndx, i, nodeid, sct, i, rbs);
+		mvcnt = genallat_b(P, mb, mvsndx, i, nodeid, sct, i, rbs);
 		for (; i>=0;i--) m->tiles[i]='\0';
 	} else if (!nldn(b, m->row, m->col, m->dir, 1)) {
 		/* look on the other side. */
@@ -2594,18 +3942,18 @@ DBG(DBG_GEN, "rcall A pos=%d depth=%d rbs=%x\n", i, i, rbs);
 			pl = b->spaces[cr][cc].b.f.letter;
 			m->tiles[i] = pl; i++;
 			nodeid = gotol(deblank(pl), cid);
-			cid = gc(gaddag[nodeid]);
+			cid = gc(gnode(nodeid));
 			sct.ttl_ts += lval(pl);
 			cr -= m->dir; cc-= (1-m->dir);
 		}
 		sct.ttl_tbs = sct.ttl_ts;
 DBG(DBG_GEN, "rcall C pos=%d depth=%d rbs=%x, mxy=%d,%d cxy=%d,%d nid=%d\n", 0, i, rbs, m->row, m->col, cr, cc, nodeid);
-		mvcnt = genallat_b(P, mvs, mvsndx, 0, cid, sct, i, rbs);
+		mvcnt = genallat_b(P, mb, mvsndx, 0, cid, sct, i, rbs);
 		for (; i>=0;i--) m->tiles[i]='\0';
 	} else {
 		/* pass-thru */
 DBG(DBG_GEN, "rcall B pos=%d depth=%d rbs=%x\n", 0, 0, rbs);
-		mvcnt = genallat_b(P, mvs, mvsndx, 0, nodeid, sct, 0, rbs);
+		mvcnt = genallat_b(P, mb, mvsndx, 0, nodeid, sct, 0, rbs);
 	}
 	return mvcnt;
 }
@@ -2613,10 +3961,11 @@ DBG(DBG_GEN, "rcall B pos=%d depth=%d rbs=%x\n", 0, 0, rbs);
 
 /* mod to use position_t. This is the most used in lah. */
 int
-genallat_b(position_t *P, move_t *mvs, int *mvsndx, int pos, int nodeid, scthingy_t sct, int depth, bs_t rbs)
+genallat_b(position_t *P, mvbuf_t *mb, int *mvsndx, int pos, int nodeid, scthingy_t sct, int depth, bs_t rbs)
 {
 	board_t *b = &(P->b);
 	move_t *m = &(P->m);
+	move_t tm;
 	rack_t *r = &(P->r);
 
 	int movecnt = 0;
@@ -2673,7 +4022,7 @@ DBG(DBG_GEN, "[%d]inline gen rbs=%x, bl=%d, bs=%x, curid=%d, rlp=%p lp=%c\n", nd
 		if (pl != '\0') {
 DBG(DBG_GEN, "[%d]found %c on board at %d, %d\n", ndx, l2c(pl), currow, curcol);
 			/* make sure we are still on the path */
-			if (bitset[nodeid] & l2b(pl)) {
+			if (gbits(nodeid) & l2b(pl)) {
 				w[ndx] = pl;
 				rlp = NULL;
 				curid = gotol(deblank(w[ndx]), nodeid);
@@ -2690,12 +4039,12 @@ DBG(DBG_GEN, "[%d]found %c on board at %d, %d\n", ndx, l2c(pl), currow, curcol);
 //				rbs = lstr2bs(r->tiles);
 				if (rbs & UBLBIT) bl = BB;
 				curid = nodeid;
-				if (bl) bs = ALLPHABITS & bitset[nodeid];
-				else bs = rbs & bitset[nodeid];
+				if (bl) bs = ALLPHABITS & gbits(nodeid);
+				else bs = rbs & gbits(nodeid);
 				if (b->spaces[currow][curcol].b.f.anchor & (1+m->dir)) {
 					bs &= b->spaces[currow][curcol].mbs[m->dir];
 				}
-DBG(DBG_GEN, "[%d]first (%d,%d)/%d bl=%x, rbs=%x, id=%d, bitset=%x mbs=%x bs=%x\n", ndx, currow, curcol, m->dir, bl, rbs, nodeid, bitset[nodeid], b->spaces[currow][curcol].mbs[m->dir], bs);
+DBG(DBG_GEN, "[%d]first (%d,%d)/%d bl=%x, rbs=%x, id=%d, bitset=%x mbs=%x bs=%x\n", ndx, currow, curcol, m->dir, bl, rbs, nodeid, gbits(nodeid), b->spaces[currow][curcol].mbs[m->dir], bs);
 			} else {
 				if (bl) {
 					setbit(&rbs, UBLANK-1);
@@ -2708,7 +4057,7 @@ DBG(DBG_GEN, "[%d] Pop %c back to rack\n", ndx,  l2c(w[ndx]));
 			}
 			if ((bs == 0) && (bl)) {
 				bl = 0;
-				bs = rbs & bitset[nodeid];
+				bs = rbs & gbits(nodeid);
 				if (b->spaces[currow][curcol].b.f.anchor & (1+m->dir)) {
 					bs &= b->spaces[currow][curcol].mbs[m->dir];
 				}
@@ -2746,7 +4095,7 @@ DBG(DBG_GEN,"[%d]match %c bl=%x, node %d rack=", ndx, l2c(pl),bl, nodeid) {
 DBG(DBG_GEN, "[%d]Gen gave id=%d, l=%c and rack ", ndx, curid, l2c(w[ndx])) {
 	printlstr(r->tiles); printf("\n");
 }
-		if (gf(gaddag[curid])) {
+		if (gf(gnode(curid))) {
 			if (nldn(b, currow, curcol, m->dir, side)) {
 /* here is where we have trouble. Check the other end. */
 			    if ((pos > 0) || (nldn(b, currow + ndx * m->dir, curcol + ndx * (1 - m->dir), m->dir, 1))) {
@@ -2755,16 +4104,15 @@ DBG(DBG_GEN, "[%d]Gen gave id=%d, l=%c and rack ", ndx, curid, l2c(w[ndx])) {
 					printmove(m, pos);
 				}
 				/* record play */
-				ASSERT(*mvsndx < MAXMVS);
-				mvs[*mvsndx] = *m;
-				fixmove( &(mvs[*mvsndx]), pos);
-				*mvsndx += 1;
+				tm = *m;
+				fixmove(&tm, pos);
+				if (!addmove(mb, mvsndx, b, &tm)) return movecnt;
 				movecnt++;
 gmcnt++;
 			    }
 			}
 		}
-		cid = gc(gaddag[curid]);
+		cid = gc(gnode(curid));
 		if (isroom(currow, curcol, m->dir, side)) {
 			/* recurse */
 DBG(DBG_GEN, "recurse 1 (%d, %d,%d, word, rack, id=%d)", m->row, m->col, pos, cid) {
@@ -2776,7 +4124,7 @@ DBG(DBG_GEN, "recurse 1 (%d, %d,%d, word, rack, id=%d)", m->row, m->col, pos, ci
 				m->col -= (1 - m->dir);
 				m->row -= m->dir;
 			}
-			movecnt += genallat_b(P, mvs, mvsndx, pos, cid, sct, depth+1, rbs);
+			movecnt += genallat_b(P, mb, mvsndx, pos, cid, sct, depth+1, rbs);
 			if (pos <= 0) {
 				m->col += (1 - m->dir);
 				m->row += m->dir;
@@ -2784,8 +4132,8 @@ DBG(DBG_GEN, "recurse 1 (%d, %d,%d, word, rack, id=%d)", m->row, m->col, pos, ci
 		} else {
 }
 		/* have to handle the ^ */
-		if ((pos <= 0) && (SEPBIT & bitset[cid])) {
-//		if ((pos <= 0) && (SEPBIT & bitset[curid]) && (sct.played > 0)) 
+		if ((pos <= 0) && (SEPBIT & gbits(cid))) {
+//		if ((pos <= 0) && (SEPBIT & gbits(curid)) && (sct.played > 0)) 
 			if (nldn(b, currow, curcol, m->dir, -1) &&
 				isroom(currow + dr*(prelen-1) , curcol + dc*(prelen-1), m->dir, 1)) {
 				sepid = gotol(SEP, cid);
@@ -2793,14 +4141,14 @@ DBG(DBG_GEN, "recurse 1 (%d, %d,%d, word, rack, id=%d)", m->row, m->col, pos, ci
 DBG(DBG_GEN, "sep at %d from %d with rack= ", sepid, cid) {
 	printlstr(r->tiles); printf(" word= "); printlstr(w); printf("\n");
 }
-				cid = gc(gaddag[sepid]);
+				cid = gc(gnode(sepid));
 				if (cid == 0) continue;
 DBG(DBG_GEN, "recurse 3 (%d, %d, 1, word, rack, id=%d", m->row, m->col, cid) {
 	printf(" - word=\""); printlstr(w);
 	printf("\", rack=\""); printlstr(r->tiles);
 	printf("\"\n");
 }
-				movecnt += genallat_b(P, mvs, mvsndx, prelen, cid, sct, depth+1, rbs);
+				movecnt += genallat_b(P, mb, mvsndx, prelen, cid, sct, depth+1, rbs);
 			} else {
 DBG(DBG_GEN, "no room! no room! at %d %d (prelen=%d)dir=%d\n", currow, curcol, prelen, m->dir);
 			}
@@ -2813,30 +4161,23 @@ DBG(DBG_GEN, "[%d] genallat for %d,%d/%d returning %d moves\n", ndx, m->row, m->
 	return movecnt;
 }
 
-/* iterates genallat over board. Allocates mvs for us.*/
+/* iterates genallat over board. Moves go in mb, from 0. */
 int
-genall_c(position_t *P, move_t **mvs, int *mvsndx)
+genall_c(position_t *P, mvbuf_t *mb, int *mvsndx)
 {
 	int r, c, dir, moves = 0;
 	bs_t rbs;
 
-	if (*mvs == NULL) {
-		*mvs = (move_t *)malloc( sizeof(move_t) * MAXMVS);
-		if (*mvs == NULL) {
-			vprintf(VNORM, "ERROR: failed allocate moves array\n");
-			return 0;
-		}
-	}
-	bzero(*mvs, sizeof(move_t)*MAXMVS);
 	*mvsndx = 0;
+	if (mb == NULL) return 0;
 	rbs = lstr2bs(P->r.tiles);
 
 	if (P->sc == -1) {
 		P->sc = 0;
 //		P->m = emptymove;
 		P->m.row = STARTR; P->m.col = STARTC; P->m.dir = M_HORIZ;
-		moves = genallat_c(P, *mvs, mvsndx);
-//		moves = genallat_b(P, *mvs, mvsndx, 0, 1, newsct, 0, rbs);
+		moves = genallat_c(P, mb, mvsndx);
+//		moves = genallat_b(P, mb, mvsndx, 0, 1, newsct, 0, rbs);
 DBG(DBG_GEN, "genall made %d start moves\n", moves);
 		return moves;
 	}
@@ -2850,8 +4191,8 @@ DBG(DBG_GEN, "genall made %d start moves\n", moves);
 					P->m.row = r; P->m.col = c;
 					P->m.dir = dir;
 
-					moves += genallat_c(P, *mvs, mvsndx);
-//					moves += genallat_b(P, *mvs, mvsndx, 0, 1, newsct, 0, rbs);
+					moves += genallat_c(P, mb, mvsndx);
+//					moves += genallat_b(P, mb, mvsndx, 0, 1, newsct, 0, rbs);
 				}
 			}
 		}
@@ -2861,28 +4202,21 @@ DBG(DBG_GEN, "genall made %d total moves (%d mvs)\n", moves, *mvsndx);
 	return moves;
 }
 
-/* iterates genallat over board. Allocates mvs for us.*/
+/* iterates genallat over board. Moves go in mb, from 0. */
 int
-genall_b(position_t *P, move_t **mvs, int *mvsndx)
+genall_b(position_t *P, mvbuf_t *mb, int *mvsndx)
 {
 	int r, c, dir, moves = 0;
 	bs_t rbs;
 
-	if (*mvs == NULL) {
-		*mvs = (move_t *)malloc( sizeof(move_t) * MAXMVS);
-		if (*mvs == NULL) {
-			vprintf(VNORM, "ERROR: failed allocate moves array\n");
-			return 0;
-		}
-	}
-	bzero(*mvs, sizeof(move_t)*MAXMVS);
 	*mvsndx = 0;
+	if (mb == NULL) return 0;
 	rbs = lstr2bs(P->r.tiles);
 
 	if (P->sc == -1) {
 		P->sc = 0;
 		P->m.row = STARTR; P->m.col = STARTC; P->m.dir = M_HORIZ;
-		moves = genallat_b(P, *mvs, mvsndx, 0, 1, newsct, 0, rbs);
+		moves = genallat_b(P, mb, mvsndx, 0, 1, newsct, 0, rbs);
 DBG(DBG_GEN, "genall made %d start moves\n", moves);
 		return moves;
 	}
@@ -2896,7 +4230,7 @@ DBG(DBG_GEN, "genall made %d start moves\n", moves);
 					P->m.row = r; P->m.col = c;
 					P->m.dir = dir;
 					
-					moves += genallat_b(P, *mvs, mvsndx, 0, 1, newsct, 0, rbs);
+					moves += genallat_b(P, mb, mvsndx, 0, 1, newsct, 0, rbs);
 				}
 			}
 		}
@@ -2970,7 +4304,7 @@ DBG(DBG_GREED, "inline gen rbs=%x, bl=%d, bs=%x, curid=%d, rlp=%p lp=%c\n", rbs,
 		if (pl != '\0') {
 DBG(DBG_GREED, "found %c on board at %d, %d\n", l2c(pl), currow, curcol);
 			/* make sure we are still on the path */
-			if (bitset[nodeid] & l2b(pl)) {
+			if (gbits(nodeid) & l2b(pl)) {
 				w[ndx] = pl;
 				rlp = NULL;
 				curid = gotol(deblank(w[ndx]), nodeid);
@@ -2987,12 +4321,12 @@ DBG(DBG_GREED, "found %c on board at %d, %d\n", l2c(pl), currow, curcol);
 				rbs = lstr2bs(r->tiles);
 				if (rbs & UBLBIT) bl = BB;
 				curid = nodeid;
-				if (bl) bs = ALLPHABITS & bitset[nodeid];
-				else bs = rbs & bitset[nodeid];
+				if (bl) bs = ALLPHABITS & gbits(nodeid);
+				else bs = rbs & gbits(nodeid);
 				if (b->spaces[currow][curcol].b.f.anchor & (1+m->dir)) {
 					bs &= b->spaces[currow][curcol].mbs[m->dir];
 				}
-DBG(DBG_GREED, "first (%d,%d)/%d bl=%x, rbs=%x, id=%d, bitset=%x mbs=%x bs=%x\n", currow, curcol, m->dir, bl, rbs, nodeid, bitset[nodeid], b->spaces[currow][curcol].mbs[m->dir], bs);
+DBG(DBG_GREED, "first (%d,%d)/%d bl=%x, rbs=%x, id=%d, bitset=%x mbs=%x bs=%x\n", currow, curcol, m->dir, bl, rbs, nodeid, gbits(nodeid), b->spaces[currow][curcol].mbs[m->dir], bs);
 			} else {
 				if (bl) *rlp = UBLANK;
 				else *rlp = w[ndx];
@@ -3000,7 +4334,7 @@ DBG(DBG_GREED, "Pop %c at %d back to rack\n", l2c(w[ndx]), ndx);
 			}
 			if ((bs == 0) && (bl)) {
 				bl = 0;
-				bs = rbs & bitset[nodeid];
+				bs = rbs & gbits(nodeid);
 				if (b->spaces[currow][curcol].b.f.anchor & (1+m->dir)) {
 					bs &= b->spaces[currow][curcol].mbs[m->dir];
 				}
@@ -3035,7 +4369,7 @@ DBG(DBG_GREED,"match %c bl=%x, node %d curid=%d rack=", l2c(pl),bl, nodeid, curi
 DBG(DBG_GREED, "Gen gave n=%d, id=%d, l=%c and rack ", ndx, curid, l2c(w[ndx])) {
 	printlstr(r->tiles); printf("\n");
 }
-		if (gf(gaddag[curid])) {
+		if (gf(gnode(curid))) {
 			if (nldn(b, currow, curcol, m->dir, side)) {
 /* here is where we have trouble. Check the other end. */
 if ((pos > 0) || (nldn(b, currow + ndx * m->dir, curcol + ndx * (1 - m->dir), m->dir, 1))) {
@@ -3050,7 +4384,7 @@ if ((pos > 0) || (nldn(b, currow + ndx * m->dir, curcol + ndx * (1 - m->dir), m-
 }
 			}
 		}
-		cid = gc(gaddag[curid]);
+		cid = gc(gnode(curid));
 		if (isroom(currow, curcol, m->dir, side)) {
 			/* recurse */
 DBG(DBG_GREED, "recurse 1 (%d, %d, %d, word, rack, id=%d)", m->row, m->col, pos, cid) {
@@ -3072,12 +4406,12 @@ DBG(DBG_GREED, "recurse 1 (%d, %d, %d, word, rack, id=%d)", m->row, m->col, pos,
 			}
 		}
 		/* have to handle the ^ */
-		if ((pos <= 0) && (SEPBIT & bitset[cid])) {
+		if ((pos <= 0) && (SEPBIT & gbits(cid))) {
 			if (nldn(b, currow, curcol, m->dir, -1) &&
 				isroom(currow + dr*(prelen-1), curcol + dc*(prelen-1), m->dir, 1)) {
 				sepid = gotol(SEP, cid);
 DBG(DBG_GREED, "sep at %d from %d\n", sepid, cid);
-				cid = gc(gaddag[sepid]);
+				cid = gc(gnode(sepid));
 				if (cid == 0) continue;
 DBG(DBG_GREED, "recurse 3 (%d, %d, 1, word, rack, id=%d", m->row, m->col, cid) {
 	printf(" - word=\""); printlstr(w);
@@ -3105,22 +4439,23 @@ DBG(DBG_GREED, "no SEP at nid %d\n", cid);
 
 /* mod to use genall_b */
 /* like all ceo's the real work is delegated to others. */
+/* mvcnt is what's in mvs, which is just 1 for a MV_BEST list. */
 int
-veep_b(position_t *P, move_t *mvs, int mvcnt)
+veep_b(position_t *P, cmove_t *mvs, int mvcnt)
 {
 	int i;
 	int bigm = 0;
 	int maxsc = 0;
 
 	for (i = 0; i < mvcnt; i++) {
-		if (mvs[i].score > maxsc) {
+		if (CM_SCORE(mvs[i]) > maxsc) {
 			bigm = i;
-			maxsc = mvs[i].score;
+			maxsc = CM_SCORE(mvs[i]);
 		}
 	}
-//	makemove6(&(P->b), &(mvs[bigm]), 1, 0, &(P->r));
-	makemove8(&(P->b), &(mvs[bigm]), 1, 0, &(P->r));
-	P->m = mvs[bigm];
+	unpackmove(&(P->b), mvs[bigm], &(P->m));
+//	makemove6(&(P->b), &(P->m), 1, 0, &(P->r));
+	makemove8(&(P->b), &(P->m), 1, 0, &(P->r), NULL);
 	P->stats.evals += mvcnt;
 	P->mvndx = bigm;
 	return maxsc;
@@ -3137,16 +4472,17 @@ ceo2_b(board_t *gb)
 	int bagpos = 0;
 	int mvcnt;
 	int mvsndx = 0;
-	move_t *mvs = NULL;
+	mvbuf_t *mb;
 	position_t P = startp;
 	bs_t rbs;
+	board_t b0;
+	rack_t r0;
+	uint64_t nank = 0, nsearch = 0;
+	hrtime_t gentime = 0, fore;
 
-	mvs = (move_t *)malloc( sizeof(move_t) * MAXMVS);
-	if (mvs == NULL) {
-		vprintf(VNORM, "ERROR: failed allocate moves array\n");
-		return 0;
-	}
-	bzero(mvs, sizeof(move_t)*MAXMVS);
+	mb = mvpush();
+	if (mb == NULL) return 0;
+	mb->keep = MV_BEST;
 
 	P.m.row = STARTR; P.m.col = STARTC;
 	fillrack(&(P.r), globalbag, &(P.bagndx));
@@ -3157,11 +4493,13 @@ DBG(DBG_GREED, "genning all at %d, %d with rack ", P.m.row, P.m.col) {
 	printlstr(P.r.tiles); printf("\n");
 }
 	rbs = lstr2bs(P.r.tiles);
-	mvcnt = genallat_b(&P, mvs, &mvsndx, 0, 1, newsct, 0, rbs);
+	mvcnt = genallat_b(&P, mb, &mvsndx, 0, 1, newsct, 0, rbs);
 
 	while (mvcnt > 0) {
-		totalscore += veep_b(&P, mvs, mvcnt);
+		b0 = P.b; r0 = P.r;
+		totalscore += veep_b(&P, mb->mvs, mvsndx);
 		P.sc = totalscore;
+		gcgmove(&b0, &r0, P.bagndx, &(P.m), totalscore);
 		VERB(VNORM, "ceo2b score is %d for ", P.sc) {
 			printmove(&(P.m), -1);
 		}
@@ -3178,11 +4516,16 @@ DBG(DBG_GREED, "genning all at %d, %d with rack ", P.m.row, P.m.col) {
 		fillrack(&(P.r), globalbag, &(P.bagndx));
 		qsort(P.r.tiles, strlen(P.r.tiles), 1, lcmp);
 		mvsndx = 0;
-		bzero(mvs, sizeof(move_t)*MAXMVS);
-//		mvcnt = genall_b(&P, &mvs, &mvsndx);
-//		mvcnt = genall_c(&P, &mvs, &mvsndx);
-		mvcnt = genall_d(&P, &mvs, &mvsndx);
+//		mvcnt = genall_b(&P, mb, &mvsndx);
+//		mvcnt = genall_c(&P, mb, &mvsndx);
+		fore = gethrtime();
+		mvcnt = genall_d(&P, mb, &mvsndx);
+		gentime += gethrtime() - fore;
+		nank += mb->nank;
+		nsearch += mb->nsearch;
 	}
+	STAT(STLOW, "greedy: searched %llu of %llu anchors, %llu nsec in genall_d\n",
+	    nsearch, nank, gentime);
 	/* correct for leftover letters. */
 	subscore = unbonus(&(P.r), globalbag, P.bagndx);
 	if (subscore > 0) {
@@ -3192,8 +4535,10 @@ DBG(DBG_GREED, "genning all at %d, %d with rack ", P.m.row, P.m.col) {
 		}
 		totalscore -= subscore;
 	}
+	gcgend(&(P.r), subscore, totalscore);
 
 	/* and that's the game, dude. */
+	mvpop(mb);
 	*gb = P.b;
 	return totalscore;
 }
@@ -3221,8 +4566,9 @@ DBG(DBG_GREED, "getting greedy at %d, %d with rack ", gm.row, gm.col) {
 	printlstr(r.tiles); printf("\n");
 }
 	maxm = greedy(gb, &gm, 0, &r, 1, newsct);
+	gcgmove(gb, &r, bagpos, &maxm, maxm.score);
 //	makemove6(gb, &maxm, 1, 0, &r);
-	makemove8(gb, &maxm, 1, 0, &r);
+	makemove8(gb, &maxm, 1, 0, &r, NULL);
 	totalscore = maxm.score;
 
 	while (strlen(maxm.tiles) > 0) {
@@ -3263,9 +4609,10 @@ VERB(VVERB, "ceo ") {
 			}
 		}
 		totalscore += maxm.score;
+		gcgmove(gb, &r, bagpos, &maxm, totalscore);
 
 //		makemove6(gb, &maxm, 1, 0, &r);
-		makemove8(gb, &maxm, 1, 0, &r);
+		makemove8(gb, &maxm, 1, 0, &r, NULL);
 	}
 	/* correct for leftover letters. */
 	subscore = unbonus(&r, globalbag, bagpos);
@@ -3276,6 +4623,7 @@ VERB(VVERB, "ceo ") {
 		}
 		totalscore -= subscore;
 	}
+	gcgend(&r, subscore, totalscore);
 
 	/* and that's the game, dude. */
 	return totalscore;
@@ -3288,10 +4636,13 @@ int
 jump(position_t *P) {
 {
 	int mcnt = 0;
+	position_t P0;
 	P->sc = -1;
 
+	P0 = *P;
 	while (lah(P, 0, level)) {
 		position_t *cP = P;
+		gcgline(&P0, P);
 		while (cP != NULL) {
 			mcnt++;
 			VERB(VNORM, "jumpy score is %d for ", cP->sc) {
@@ -3300,27 +4651,197 @@ jump(position_t *P) {
 			*P = *cP;
 			cP = cP->next;
 		}
+		P0 = *P;
 	}
+	gcgend(&(P->r), P0.sc - P->sc, P->sc);
 DBG(DBG_LAH, "jump mv %d score =%d\n",mcnt, P->sc);
 	}
 
 	return P->sc;
 }
 
-/* creep uses lah, it only does 1 move/iteration.
-*/
-int
-creep(position_t *P)
+/* checksum of the bag, so a checkpoint isn't resumed on another. */
+uint32_t
+bagsum()
 {
-	int mcnt = 0;
-	P->sc = -1;
-	int rv = 1;
-	hrtime_t fore, aft;
+	uint32_t h = 2166136261U;
+	int i;
 
+	for (i = 0; i < baglen; i++) {
+		h = (h ^ (uint8_t)globalbag[i]) * 16777619U;
+	}
+	return h;
+}
+
+/* room for the moves of a game. returns 0 if we can't. */
+int
+ckinit()
+{
+	if (ckmvs != NULL) return 1;
+	ckmvs = (move_t *)malloc((baglen + 2) * sizeof(move_t));
+	if (ckmvs == NULL) {
+		vprintf(VNORM, "ERROR: no memory for checkpoints\n");
+		return 0;
+	}
+	cknm = 0;
+	cklast = gethrtime();
+	return 1;
+}
+
+/* remember a move made in the game. */
+void
+ckmove(move_t *m)
+{
+	if ((ckmvs == NULL) || (cknm >= baglen + 2)) return;
+	ckmvs[cknm++] = *m;
+}
+
+/* is it time for another checkpoint? */
+inline int
+cktime()
+{
+	return (ckmvs != NULL) && (gethrtime() - cklast > CKSECS * 1000000000LLU);
+}
+
+/*
+ * write a checkpoint of the game P is in. With k > 0, the root search
+ * for the next move has done children up to k, best so far maxsc from
+ * child maxi. Written to a temp file and renamed, so there's always a
+ * whole one. Returns 0 if that didn't work; the search goes on anyway.
+ */
+int
+cksave(position_t *P, int limit, int k, int maxsc, int maxi)
+{
+	ckhead_t h;
+	char tmp[PATH_MAX];
+	FILE *f;
+	int ok;
+
+	if (ckmvs == NULL) return 0;
+	bzero(&h, sizeof(h));
+	h.magic = CKMAGIC;
+	h.version = CKVERSION;
+	h.bagsum = bagsum();
+	h.strat = strat;
+	h.level = level;
+	h.prune = prune;
+	h.nmoves = cknm;
+	h.limit = limit;
+	h.k = k;
+	h.maxsc = maxsc;
+	h.maxi = maxi;
+	h.stats = P->stats;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", ckfn);
+	f = fopen(tmp, "w");
+	if (f == NULL) {
+		VERB(VNORM, "ERROR: checkpoint ") {
+			perror(tmp);
+		}
+		return 0;
+	}
+	ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+	if (ok && (cknm > 0)) ok = (fwrite(ckmvs, sizeof(move_t), cknm, f) == cknm);
+	if (ok) ok = (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+	if ((fclose(f) != 0) || !ok || (rename(tmp, ckfn) != 0)) {
+		VERB(VNORM, "ERROR: checkpoint ") {
+			perror(ckfn);
+		}
+		unlink(tmp);
+		return 0;
+	}
+	cklast = gethrtime();
+	stprintf(STHI, "checkpoint: %d moves, part %d\n", cknm, k);
+	return 1;
+}
+
+/*
+ * make m on P the way lah() did: the rack is filled for it first.
+ * With -o, it's written out like any other move.
+ */
+void
+replay(position_t *P, move_t *m)
+{
+	fillrack(&(P->r), globalbag, &(P->bagndx));
+	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+	if (P->sc == -1) P->sc = 0;
+	gcgmove(&(P->b), &(P->r), P->bagndx, m, P->sc + m->score);
+	makemove8(&(P->b), m, 1, 0, &(P->r), NULL);
+	P->sc += m->score;
+	P->m = *m;
+	P->depth++;
+}
+
+/*
+ * restart: replay the moves in the checkpoint on P, a fresh game. Its part way search, if any, goes in ckres
+ * for lah() to pick up. Returns moves replayed, -1 if it's no good.
+ */
+int
+ckload(position_t *P)
+{
+	ckhead_t h;
+	move_t m;
+	FILE *f;
+	int i;
+
+	f = fopen(ckfn, "r");
+	if (f == NULL) {
+		VERB(VNORM, "ERROR: can't resume: ") {
+			perror(ckfn);
+		}
+		return -1;
+	}
+	if ((fread(&h, sizeof(h), 1, f) != 1) || (h.magic != CKMAGIC) ||
+	    (h.version != CKVERSION)) {
+		vprintf(VNORM, "ERROR: %s is not a checkpoint\n", ckfn);
+		fclose(f);
+		return -1;
+	}
+	if ((h.bagsum != bagsum()) || (h.strat != strat) || (h.level != level) ||
+	    (h.prune != prune) || (h.nmoves < 0) || (h.nmoves > baglen + 1)) {
+		vprintf(VNORM, "ERROR: %s is for another game or search\n", ckfn);
+		fclose(f);
+		return -1;
+	}
+	for (i = 0; i < h.nmoves; i++) {
+		if (fread(&m, sizeof(m), 1, f) != 1) {
+			vprintf(VNORM, "ERROR: %s is cut short\n", ckfn);
+			fclose(f);
+			return -1;
+		}
+		replay(P, &m);
+		ckmove(&m);
+	}
+	fclose(f);
+	P->stats = h.stats;
+	ckres = h;
+	vprintf(VVERB, "resumed %d moves from %s, score %d\n", h.nmoves, ckfn, P->sc);
+	return h.nmoves;
+}
+
+/* creep uses lah, it only does 1 move/iteration.
+ * with -k, checkpoints the game every CKSECS, and -r restarts it.
+*/
+int
+creep(position_t *P)
+{
+	int mcnt = 0;
+	P->sc = -1;
+	int rv = 1;
+	hrtime_t fore, aft;
+	position_t P0;
+
+	if (ckfn != NULL) {
+		if (!ckinit()) return 0;
+		if (ckresume && (ckload(P) < 0)) return 0;
+	}
+	P0 = *P;
 	fore = gethrtime();
 	rv = lah(P, 0, level);
 	aft = gethrtime();
 	while (rv) {
+		ckmove(&(P->m));
+		gcgmove(&(P0.b), &(P0.r), P0.bagndx, &(P->m), P->sc);
 mcnt += P->stats.moves;
 		P->stats.evtime += aft - fore;
 		P->depth++;
@@ -3333,115 +4854,1170 @@ DBG(DBG_CREEP, "creep chain is:\n") {
 	}
 }
 DBG(DBG_CREEP, "mv %dscore =%d P->next = %p\n", P->depth, P->sc,  P->next);
+		if (cktime()) cksave(P, 0, 0, 0, 0);
+		P0 = *P;
 		fore = gethrtime();
 		rv = lah(P, 0, level);
 		aft = gethrtime();
 	}
+	gcgend(&(P->r), P0.sc - P->sc, P->sc);
+	if (ckfn != NULL) cksave(P, 0, 0, 0, 0);
 vprintf(VVERB, "total moves is %d\n", mcnt);
 	return P->sc;
 }
 
 /*
- * at last. look-ahead. needs to know limit, depth, position.
- * uses genall.  Greedy when limit is reached.
- * not a strat itself, but used by them (like greedy). 
- * returns 0 when there are no more moves.
- * newP is allocated.
+ * set up the transposition table, mb megabytes rounded down to a power
+ * of 2 buckets. Leaves ttab NULL (no table) if it can't.
+ */
+void
+ttinit(int mb)
+{
+	uint64_t nb;
+
+	nb = ((uint64_t)mb << 20) / (sizeof(ttent_t) * TTWAYS);
+	while (nb & (nb - 1)) nb &= nb - 1;
+	if (nb == 0) return;
+	ttab = (ttent_t *)calloc(nb * TTWAYS, sizeof(ttent_t));
+	if (ttab == NULL) {
+		vprintf(VNORM, "ERROR: no memory for %d MB table, running without\n", mb);
+		return;
+	}
+	ttmask = nb - 1;
+	vprintf(VVERB, "transposition table: %llu buckets of %d\n", nb, TTWAYS);
+}
+
+/* empty the table, so each --bench game starts cold. */
+void
+ttclear()
+{
+	if (ttab == NULL) return;
+	bzero(ttab, (ttmask + 1) * TTWAYS * sizeof(ttent_t));
+}
+
+/* zobrist key for a position: board hash, rack, bag index. */
+uint64_t
+tthash(position_t *P)
+{
+	uint64_t h = P->b.hash ^ zbag[P->bagndx & 0xFF] ^ bagkey;
+	int cnt[64];
+	letter_t l;
+	int i;
+
+	bzero(cnt, sizeof(cnt));
+	for (i = 0; i < RACKSIZE; i++) {
+		l = P->r.tiles[i];
+		if ((l == '\0') || (l == MARK)) continue;
+		h ^= zrack[l & 0x3F][cnt[l & 0x3F]++];
+	}
+	return h;
+}
+
+/* look for key searched to lv levels. Returns 1 and data if found. */
+int
+ttprobe(uint64_t key, int lv, uint64_t *data)
+{
+	ttent_t *e = &(ttab[(key & ttmask) * TTWAYS]);
+	uint64_t d;
+	int w;
+
+	for (w = 0; w < TTWAYS; w++) {
+		d = e[w].data;
+		if (((e[w].kx ^ d) == key) && (TTLV(d) == lv)) {
+			*data = d;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * replacement: first slot keeps the deepest search, unless it's the
+ * same key; everything else goes in the second slot.
+ */
+void
+ttstore(uint64_t key, uint64_t data)
+{
+	ttent_t *e = &(ttab[(key & ttmask) * TTWAYS]);
+	uint64_t d = e[0].data;
+
+	if (((e[0].kx ^ d) != key) && (TTLV(d) > TTLV(data))) {
+		e++;
+	}
+	e->data = data;
+	e->kx = key ^ data;
+}
+
+/* how many entries are in use. */
+uint64_t
+ttused()
+{
+	uint64_t i, n = 0;
+
+	for (i = 0; i < (ttmask + 1) * TTWAYS; i++) {
+		if (ttab[i].data != 0) n++;
+	}
+	return n;
+}
+
+/* sum child stats into st. */
+void
+addstats(gstats_t *st, gstats_t *kst)
+{
+	st->moves += kst->moves;
+	st->evtime += kst->evtime;
+	st->tthits += kst->tthits;
+	st->ttmisses += kst->ttmisses;
+	st->cuts += kst->cuts;
+	if (kst->maxdepth > st->maxdepth) st->maxdepth = kst->maxdepth;
+	if (kst->maxwidth > st->maxwidth) st->maxwidth = kst->maxwidth;
+	if (kst->wordhs > st->wordhs) st->wordhs = kst->wordhs;
+}
+
+/* throw away a look-ahead chain. */
+void
+freechain(position_t *P)
+{
+	position_t *nP;
+
+	while (P != NULL) {
+		nP = P->next;
+		free(P);
+		P = nP;
+	}
+}
+
+/*
+ * -p: what child i has to beat to matter. Better than the best so
+ * far, or as good if it comes earlier in move order, and better than
+ * what the parent has to beat. Without -p everything matters.
+ */
+inline int
+kidfloor(int floor, int maxsc, int maxi, int i)
+{
+	int f;
+
+	if (!prune) return LOWSCORE;
+	f = (i < maxi) ? maxsc - 1 : maxsc;
+	return (f > floor) ? f : floor;
+}
+
+/*
+ * -p: the order to try mvs in, best score first, so there's a good
+ * floor early. Kept in ob. NULL means use move order.
+ */
+uint64_t *
+mvorder(mvbuf_t *ob, cmove_t *mvs, int mvcnt)
+{
+	int i;
+
+	if (ob == NULL) return NULL;
+	for (i = 0; i < mvcnt; i++) {
+		if (!mvroom(ob, i)) return NULL;
+		ob->mvs[i] = ORDKEY(CM_SCORE(mvs[i]), i);
+	}
+	qsort(ob->mvs, mvcnt, sizeof(uint64_t), ankcmp);
+	return ob->mvs;
+}
+
+/*
+ * owner side: push children lo..hi-1 of J, last one first, so the
+ * owner pops them in move order and thieves get the far end.
+ * Returns the lowest index pushed; the rest didn't fit.
+ */
+int
+dqpush(lahjob_t *J, int lo, int hi)
+{
+	deque_t *d = &(dq[mytid]);
+	int i = hi;
+
+	pthread_mutex_lock(&(d->lock));
+	while ((i > lo) && (d->bot - d->top < DQSIZE)) {
+		i--;
+		d->t[d->bot % DQSIZE].J = J;
+		d->t[d->bot % DQSIZE].i = i;
+		d->bot++;
+	}
+	pthread_mutex_unlock(&(d->lock));
+	return i;
+}
+
+/* owner side: take the newest task, but only if it's one of J's. */
+int
+dqpop(lahjob_t *J, task_t *t)
+{
+	deque_t *d = &(dq[mytid]);
+	int rv = 0;
+
+	pthread_mutex_lock(&(d->lock));
+	if ((d->bot != d->top) && (d->t[(d->bot - 1) % DQSIZE].J == J)) {
+		d->bot--;
+		*t = d->t[d->bot % DQSIZE];
+		rv = 1;
+	}
+	pthread_mutex_unlock(&(d->lock));
+	return rv;
+}
+
+/* thief side: take the oldest task from the next thread that has one. */
+int
+dqsteal(task_t *t)
+{
+	deque_t *d;
+	int k, v;
+
+	for (k = 1; k <= poolsize; k++) {
+		v = (mytid + k) % (poolsize + 1);
+		d = &(dq[v]);
+		if (d->bot == d->top) continue;		/* peek, no lock */
+		pthread_mutex_lock(&(d->lock));
+		if (d->bot != d->top) {
+			*t = d->t[d->top % DQSIZE];
+			d->top++;
+			pthread_mutex_unlock(&(d->lock));
+			tstats[mytid].steals++;
+			return 1;
+		}
+		pthread_mutex_unlock(&(d->lock));
+	}
+	return 0;
+}
+
+/*
+ * search one child of a split node and reduce it into the job.
+ * Jobs that aren't splits bring their own run function instead.
+ * The child gets its own copy of the parent to make its move on.
+ * Same winner as the serial loop: first best in move order.
+ * Its floor comes from the best so far when it starts; that only
+ * goes up, so a child that fails low can't win the reduction.
+ * Dropping pending is the last touch, J may be gone after that.
+ */
+void
+runtask(task_t *t)
+{
+	lahjob_t *J = t->J;
+	move_t m;
+	position_t iP;
+	hrtime_t fore, aft;
+	int i, v, f;
+
+	globalbag = J->bag;
+	baglen = J->baglen;
+	bagkey = J->bagkey;
+	deadline = J->deadline;
+	/* a task started after the deadline stops at once */
+	globaldone = (deadline != 0) && (gethrtime() > deadline);
+	if (J->run != NULL) {
+		J->run(t);
+		__sync_fetch_and_sub(&(J->pending), 1);
+		return;
+	}
+	i = (J->ord != NULL) ? ORDNDX(J->ord[t->i]) : t->i;
+	iP = *(J->P);
+	iP.stats = nullstats;
+	unpackmove(&(iP.b), J->mvs[i], &m);
+DBG(DBG_LAH, "[%d]task with move %d=", J->depth, i) {
+	printmove(&m, -1);
+}
+	makemove8(&(iP.b), &m, 1, 0, &(iP.r), NULL);
+	iP.sc += m.score;
+	if (m.score > iP.stats.wordhs) iP.stats.wordhs = m.score;
+	pthread_mutex_lock(&(J->lock));
+	f = kidfloor(J->floor, J->maxsc, J->maxi, i);
+	pthread_mutex_unlock(&(J->lock));
+	fore = gethrtime();
+	v = lahval(&iP, J->depth+1, J->limit, f);
+	aft = gethrtime();
+	iP.stats.evtime = aft - fore;
+	pthread_mutex_lock(&(J->lock));
+	if ((v > J->maxsc) || ((v == J->maxsc) && (i < J->maxi))) {
+		J->maxsc = v;
+		J->maxi = i;
+	}
+	addstats(&(J->stats), &(iP.stats));
+	pthread_mutex_unlock(&(J->lock));
+	__sync_fetch_and_sub(&(J->pending), 1);
+}
+
+/* --bench: add this thread's move gen counts to the totals. */
+void
+benchfold()
+{
+	__sync_fetch_and_add(&benchgens, bgens);
+	__sync_fetch_and_add(&benchgmoves, bgmoves);
+	__sync_fetch_and_add(&benchgtime, bgtime);
+	bgens = bgmoves = bgtime = 0;
+}
+
+/* pool thread. sleeps between searches, steals while one is running. */
+void *
+worker(void *arg)
+{
+	int gen = 0;
+	task_t t;
+
+	mytid = (int)(intptr_t)arg;
+	for (;/*EVER*/;) {
+		pthread_mutex_lock(&poollock);
+		while (jobgen == gen) {
+			pthread_cond_wait(&poolcv, &poollock);
+		}
+		gen = jobgen;
+		pthread_mutex_unlock(&poollock);
+
+		while (poolrun) {
+			if (dqsteal(&t)) {
+				runtask(&t);
+			} else {
+				tstats[mytid].idles++;
+				sched_yield();
+			}
+		}
+
+		pthread_mutex_lock(&poollock);
+		wmcnt += gmcnt; gmcnt = 0;
+		if (benching) benchfold();
+		busy--;
+		if (busy == 0) pthread_cond_signal(&donecv);
+		pthread_mutex_unlock(&poollock);
+	}
+	return NULL;
+}
+
+/* start up the pool, once. returns number of workers running. */
+int
+startpool()
+{
+	int rv, i;
+
+	if (poolsize > 0) return poolsize;
+	if (nthreads > MAXTHREADS) nthreads = MAXTHREADS;
+	for (i = 0; i < nthreads; i++) {
+		pthread_mutex_init(&(dq[i].lock), NULL);
+		dq[i].top = dq[i].bot = 0;
+	}
+	while (poolsize < nthreads - 1) {
+		rv = pthread_create(&(workers[poolsize]), NULL, worker,
+		    (void *)(intptr_t)(poolsize + 1));
+		if (rv != 0) {
+			VERB(VNORM, "only started %d of %d workers\n", poolsize, nthreads - 1) {
+				errno = rv; perror("pthread_create");
+			}
+			break;
+		}
+		poolsize++;
+	}
+	vprintf(VVERB, "started %d worker threads\n", poolsize);
+	return poolsize;
+}
+
+/* total steals and idles over all threads. */
+void
+poolstats(gstats_t *st)
+{
+	int i;
+
+	st->steals = 0; st->idles = 0;
+	for (i = 0; i <= poolsize; i++) {
+		st->steals += tstats[i].steals;
+		st->idles += tstats[i].idles;
+	}
+}
+
+/*
+ * run tasks 0..n-1 of J on the pool and wait for them all.
+ * They go on our deque; we work them in order while others steal.
+ * Waiting for the join, we help with other work, but not too deep.
+ * The outermost job wakes the pool up and puts it back to sleep,
+ * adds the pool's steals and idles to st, and returns 1.
+ */
+int
+runjob(lahjob_t *J, int n, gstats_t *st)
+{
+	gstats_t ps0, ps1;
+	task_t t;
+	int i, lo;
+	int top = !poolrun;
+
+	J->pending = n;
+	J->bag = globalbag;
+	J->baglen = baglen;
+	J->bagkey = bagkey;
+	J->deadline = deadline;
+	pthread_mutex_init(&(J->lock), NULL);
+	if (top) {
+		startpool();
+		poolstats(&ps0);
+		pthread_mutex_lock(&poollock);
+		poolrun = 1;
+		busy = poolsize;
+		jobgen++;
+		pthread_cond_broadcast(&poolcv);
+		pthread_mutex_unlock(&poollock);
+	}
+
+	lo = dqpush(J, 0, n);
+	for (i = 0; i < lo; i++) {
+		t.J = J; t.i = i;
+		runtask(&t);
+	}
+	while (J->pending > 0) {
+		if (dqpop(J, &t)) {
+			runtask(&t);
+		} else if ((helping < MAXHELP) && dqsteal(&t)) {
+			helping++;
+			runtask(&t);
+			helping--;
+		} else {
+			tstats[mytid].idles++;
+			sched_yield();
+		}
+	}
+	__sync_synchronize();
+	pthread_mutex_destroy(&(J->lock));
+	/* if time ran out on a helper, it's out for us too */
+	if ((deadline != 0) && (gethrtime() > deadline)) globaldone = 1;
+
+	if (top) {
+		pthread_mutex_lock(&poollock);
+		poolrun = 0;
+		while (busy > 0) {
+			pthread_cond_wait(&donecv, &poollock);
+		}
+		pthread_mutex_unlock(&poollock);
+		poolstats(&ps1);
+		st->steals += ps1.steals - ps0.steals;
+		st->idles += ps1.idles - ps0.idles;
+	}
+	return top;
+}
+
+/*
+ * the threaded loop over the mvcnt children of P. Returns the best
+ * child's value, the same as the serial loop would, and which child
+ * it was in *maxi. Children are tried in ord order if there is one,
+ * and a value at or below floor just means none of them beat it.
+ * P itself is only read; stats are summed into it.
+ */
+int
+lahsplit(position_t *P, cmove_t *mvs, uint64_t *ord, int mvcnt, int depth, int limit, int floor, int *maxi)
+{
+	lahjob_t J;
+	gstats_t st;
+
+	J.P = P;
+	J.run = NULL;
+	J.mvs = mvs;
+	J.ord = ord;
+	J.floor = floor;
+	J.depth = depth;
+	J.limit = limit;
+	J.maxsc = LOWSCORE;
+	J.maxi = mvcnt;
+	J.stats = nullstats;
+
+	st = P->stats;
+	if (runjob(&J, mvcnt, &st)) {
+		globalstats.moves += J.stats.moves;
+		globalstats.evals += mvcnt;
+	}
+	addstats(&st, &(J.stats));
+	P->stats = st;
+	*maxi = J.maxi;
+DBG(DBG_LAH, "[%d]split returning for score %d with move %d\n", depth, J.maxsc, J.maxi);
+	return J.maxsc;
+}
+
+/*
+ * look-ahead, value only: the score at the end of the best line from P,
+ * without building the line. Moves are made and unmade in place, so P
+ * comes back as it went in, apart from its stats.
+ * With -p this is branch and bound: only values above floor matter.
+ * Leaves skip anchors whose bound can't get there, and children go
+ * best score first so their floors come up fast. A value at or below
+ * floor is then only an upper bound, so it doesn't go in the table.
+ */
+int
+lahval(position_t *P, int depth, int limit, int floor)
+{
+	mvbuf_t *mb, *ob = NULL;
+	cmove_t *mvs;
+	uint64_t *ord = NULL;
+	move_t m;
+	int mvsndx = 0;
+	int mvcnt, i, k, v;
+	int maxsc = LOWSCORE;
+	int maxi;
+	rack_t r0 = P->r, r1;
+	int bagndx0 = P->bagndx;
+	int sc0 = P->sc;
+	move_t m0 = P->m;
+	uint64_t key, ttd;
+	undo_t u;
+
+	if (timeup()) return LOWSCORE;
+	fillrack(&(P->r), globalbag, &(P->bagndx));
+	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+	r1 = P->r;
+	if (ttab) {
+		key = tthash(P);
+		if (ttprobe(key, limit - depth, &ttd)) {
+			P->stats.tthits++;
+			maxsc = sc0 + TTSC(ttd);
+			goto out;
+		}
+		P->stats.ttmisses++;
+	}
+	mb = mvpush();
+	if ((mb != NULL) && (depth >= limit)) {
+		mb->keep = MV_BEST;
+		mb->floor = floor - sc0;
+	}
+	mvcnt = genall_d(P, mb, &mvsndx);
+	if (mb != NULL) mvs = mb->mvs;
+	P->stats.moves += mvcnt;
+	if (depth > P->stats.maxdepth) P->stats.maxdepth = depth;
+	if (mvcnt > P->stats.maxwidth) P->stats.maxwidth = mvcnt;
+	if ((mb != NULL) && (mb->cut > 0)) P->stats.cuts++;
+
+	if ((mvcnt == 0) && (mb != NULL) && (mb->cut > 0)) {
+		/* nothing can beat floor. maybe EOG, which can't either */
+		maxsc = floor;
+	} else if (mvcnt == 0) {
+		/* EOG */
+		maxsc = sc0 - unbonus(&(P->r), globalbag, P->bagndx);
+	} else if (depth >= limit) {
+		/* greedy, like veep_b, but don't make the move */
+		maxsc = CM_SCORE(mvs[0]);
+		P->stats.evals += mvsndx;
+		if (maxsc > P->stats.wordhs) P->stats.wordhs = maxsc;
+		maxsc += sc0;
+		if (ttab && (maxsc > floor)) ttstore(key, TTPACK(maxsc - sc0, 0));
+	} else {
+		maxi = mvcnt;
+		if (prune) {
+			ob = mvpush();
+			ord = mvorder(ob, mvs, mvcnt);
+		}
+		if ((nthreads > 1) && (mvcnt > 1)) {
+			maxsc = lahsplit(P, mvs, ord, mvcnt, depth, limit, floor, &maxi);
+		} else for (k = 0; k < mvcnt; k++) {
+			i = (ord != NULL) ? ORDNDX(ord[k]) : k;
+			unpackmove(&(P->b), mvs[i], &m);
+			makemove8(&(P->b), &m, 1, 0, &(P->r), &u);
+			P->sc = sc0 + m.score;
+			if (m.score > P->stats.wordhs) P->stats.wordhs = m.score;
+			v = lahval(P, depth+1, limit, kidfloor(floor, maxsc, maxi, i));
+			unmakemove(&(P->b), &u);
+			P->r = r1;
+			P->sc = sc0;
+			if ((v > maxsc) || ((v == maxsc) && (i < maxi))) {
+				maxsc = v;
+				maxi = i;
+			}
+		}
+		mvpop(ob);
+		/* if time ran out, maxsc is junk. nobody will look at it */
+		if (ttab && (maxsc > floor) && !globaldone) ttstore(key, TTPACK(maxsc - sc0, limit - depth));
+	}
+	mvpop(mb);
+out:
+	P->r = r0;
+	P->bagndx = bagndx0;
+	P->sc = sc0;
+	P->m = m0;
+	return maxsc;
+}
+
+/*
+ * at last. look-ahead. needs to know limit, depth, position.
+ * uses genall.  Greedy when limit is reached.
+ * not a strat itself, but used by them (like greedy). 
+ * returns 0 when there are no more moves, or when time ran out.
+ * Children are valued with lahval(), making and unmaking moves in
+ * place. Then the best one is made on P, and its line is built in
+ * P->next by searching it again, one allocated position per level.
+ * with -j, the children of every look-ahead level are split into tasks.
+ * with -h, lahval() keeps searched nodes in the transposition table,
+ * so the second search down the line is mostly hits.
+ */
+int
+lah(position_t *P, int depth, int limit)
+{
+	mvbuf_t *mb;
+	cmove_t *mvs;
+	move_t m;
+	int mvsndx = 0;
+	mvbuf_t *ob = NULL;
+	uint64_t *ord = NULL;
+	position_t *kid;
+	int maxsc = LOWSCORE;
+	int maxi;
+	int i, k, k0, v, rv;
+	rack_t r1;
+	uint64_t key;
+	int sc0;
+	undo_t u;
+	hrtime_t fore, aft;
+
+	fillrack(&(P->r), globalbag, &(P->bagndx));
+	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+DBG(DBG_LAH, "enter depth=%d limit=%d rack=", depth, limit) {
+	printlstr(P->r.tiles); printf("\n");
+}
+	if (ttab) key = tthash(P);
+	P->m = emptymove;
+	mb = mvpush();
+	if ((mb != NULL) && (depth >= limit)) mb->keep = MV_BEST;
+//	P->mvcnt = genall_b(P, mb, &mvsndx);
+//	P->mvcnt = genall_c(P, mb, &mvsndx);
+	P->mvcnt = genall_d(P, mb, &mvsndx);
+	if (mb != NULL) mvs = mb->mvs;
+	P->stats.moves += P->mvcnt;
+	if (depth > P->stats.maxdepth) P->stats.maxdepth = depth;
+	if (P->mvcnt > P->stats.maxwidth) P->stats.maxwidth = P->mvcnt;
+
+DBG(DBG_LAH, "[%d]genall gave %d (%d)moves\n",depth, P->mvcnt, mvsndx);
+	if (P->mvcnt == 0) {
+		/* there were no more moves. EOG */
+		P->sc -= unbonus(&(P->r), globalbag, P->bagndx);
+		P->best = P->sc;
+		P->next = NULL;
+		mvpop(mb); mvsndx = 0;
+		return 0;
+	}
+	if (depth >= limit) {
+		int score = veep_b(P, mvs, mvsndx);
+		P->sc += score;
+		P->best = P->sc;
+		if (score > P->stats.wordhs) P->stats.wordhs = score;
+		P->next = NULL;
+		if (ttab) ttstore(key, TTPACK(score, 0));
+		mvpop(mb); mvsndx = 0;
+DBG(DBG_LAH, "[%d]veep found (%d) move =", depth, P->sc) {
+	printmove(&(P->m), -1);
+}
+		return 1;
+	}
+	/* still looking ahead. recursive part. */
+	ASSERT(depth < limit);
+	sc0 = P->sc;		/* after genall, which starts it at 0 */
+	maxi = P->mvcnt;
+	k0 = 0;
+	if ((depth == 0) && (ckres.k > 0) && (ckres.limit == limit) && (ckres.nmoves == cknm)) {
+		/* restarted part way through this one */
+		k0 = ckres.k;
+		maxsc = ckres.maxsc;
+		maxi = ckres.maxi;
+	}
+	ckres.k = 0;
+	if (prune) {
+		ob = mvpush();
+		ord = mvorder(ob, mvs, P->mvcnt);
+	}
+	if ((nthreads > 1) && (P->mvcnt > 1)) {
+		maxsc = lahsplit(P, mvs, ord, P->mvcnt, depth, limit, LOWSCORE, &maxi);
+	} else {
+		r1 = P->r;
+		for (k = k0; k < P->mvcnt; k++) {
+			i = (ord != NULL) ? ORDNDX(ord[k]) : k;
+			unpackmove(&(P->b), mvs[i], &m);
+DBG(DBG_LAH, "[%d]recurse with move %d=", depth,i) {
+	printmove(&m, -1);
+}
+			makemove8(&(P->b), &m, 1, 0, &(P->r), &u);
+			P->sc = sc0 + m.score;
+			if (m.score > P->stats.wordhs) P->stats.wordhs = m.score;
+			fore = gethrtime();
+			v = lahval(P, depth+1, limit, kidfloor(LOWSCORE, maxsc, maxi, i));
+			aft = gethrtime();
+			P->stats.evtime += aft - fore;
+			unmakemove(&(P->b), &u);
+			P->r = r1;
+			P->sc = sc0;
+			if ((v > maxsc) || ((v == maxsc) && (i < maxi))) {
+				maxsc = v;
+				maxi = i;
+			}
+			if ((depth == 0) && cktime() && !globaldone) {
+				cksave(P, limit, k + 1, maxsc, maxi);
+			}
+		}
+	}
+	mvpop(ob);
+	if (globaldone) {
+		/* out of time. P is as it was after genall */
+		mvpop(mb); mvsndx = 0;
+		return 0;
+	}
+	/* make the winner for real, then get its line. */
+	unpackmove(&(P->b), mvs[maxi], &(P->m));
+	makemove8(&(P->b), &(P->m), 1, 0, &(P->r), NULL);
+	P->mvndx = maxi;
+	P->sc = sc0 + P->m.score;
+	P->best = maxsc;
+	P->next = NULL;
+	kid = malloc(sizeof(position_t));
+	if (kid == NULL) {
+		vprintf(VNORM, "ERROR: failed to allocate position\n");
+	} else {
+		*kid = *P;
+		kid->stats = nullstats;
+		rv = lah(kid, depth+1, limit);
+		addstats(&(P->stats), &(kid->stats));
+		ASSERT(globaldone || (kid->best == maxsc));
+		// in the case where next move is no move, free it.
+		if (rv == 0) {
+			free(kid);
+		} else {
+			P->next = kid;
+		}
+	}
+	if (ttab && !globaldone) ttstore(key, TTPACK(maxsc - sc0, limit - depth));
+DBG(DBG_LAH, "[%d]returning for score %d/%d/%d with move=", depth, maxsc, P->sc, P->m.score) {
+	printmove( &(P->m), -1);
+	showboard(P->b, B_TILES);
+}
+	mvpop(mb); mvsndx = 0;
+	return 2;
+}
+
+/*
+ * rough worth of what's left in rack r after cm, for ranking beam
+ * entries. Blanks and an S help the next move, doubled letters
+ * and racks of all vowels or no vowels don't.
+ */
+int
+leaveval(rack_t *r, cmove_t cm)
+{
+	int cnt[UBLANK+1];
+	int i, n = 0, nv = 0, v = 0;
+	letter_t l;
+
+	bzero(cnt, sizeof(cnt));
+	for (i = 0; r->tiles[i] != '\0'; i++) {
+		if (r->tiles[i] <= UBLANK) cnt[r->tiles[i]]++;
+	}
+	for (i = 0; (i < RACKSIZE) && ((l = CM_TILE(cm, i)) != '\0'); i++) {
+		cnt[CM_BLANK(cm, i) ? UBLANK : l]--;
+	}
+	for (l = 1; l <= UBLANK; l++) {
+		if (cnt[l] <= 0) continue;
+		n += cnt[l];
+		if (strchr("AEIOU", l2c(l)) != NULL) nv += cnt[l];
+		v -= 3 * (cnt[l] - 1);
+	}
+	v += 8 * cnt[UBLANK];
+	if (cnt[C2l('S')] > 0) v += 4;
+	if ((n > 1) && ((nv == 0) || (nv == n))) v -= 2 * n;
+	return v;
+}
+
+/* put c in list l of n, at most w, best rank first. returns new n. */
+int
+bkeep(bcand_t *l, int n, int w, bcand_t *c)
+{
+	int i;
+
+	if ((n == w) && (c->rank <= l[n-1].rank)) return n;
+	if (n < w) n++;
+	for (i = n - 1; (i > 0) && (c->rank > l[i-1].rank); i--) {
+		l[i] = l[i-1];
+	}
+	l[i] = *c;
+	return n;
+}
+
+/*
+ * expand beam entry t->i: its best w moves, into its part of B->c.
+ * A finished game just offers itself, ranked by its final score.
+ */
+void
+beamtask(task_t *t)
+{
+	beam_t *B = (beam_t *)(t->J->arg);
+	position_t *P = &(B->P[t->i]);
+	bcand_t *l = &(B->c[t->i * B->w]);
+	bcand_t c;
+	mvbuf_t *mb;
+	int mvsndx = 0;
+	int mvcnt, k, n = 0;
+	hrtime_t fore, aft;
+
+	c.from = t->i;
+	c.cm = 0;
+	if (P->state == DONE) {
+		c.rank = P->sc;
+		B->nc[t->i] = bkeep(l, 0, B->w, &c);
+		return;
+	}
+	fillrack(&(P->r), globalbag, &(P->bagndx));
+	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+	mb = mvpush();
+	fore = gethrtime();
+	mvcnt = genall_d(P, mb, &mvsndx);
+	aft = gethrtime();
+	P->stats.evtime += aft - fore;
+	P->stats.moves += mvcnt;
+	P->stats.evals += mvsndx;
+	if (mvcnt > P->stats.maxwidth) P->stats.maxwidth = mvcnt;
+	if (mvcnt == 0) {
+		/* EOG */
+		P->sc -= unbonus(&(P->r), globalbag, P->bagndx);
+		P->state = DONE;
+		c.rank = P->sc;
+		n = bkeep(l, 0, B->w, &c);
+	}
+	for (k = 0; k < mvsndx; k++) {
+		c.cm = mb->mvs[k];
+		c.rank = P->sc + CM_SCORE(c.cm) + leaveval(&(P->r), c.cm);
+		n = bkeep(l, n, B->w, &c);
+	}
+	mvpop(mb);
+	B->nc[t->i] = n;
+}
+
+/*
+ * beam search: play the beamw best games so far a turn at a time,
+ * until they are all over. With -j, each turn's entries are expanded
+ * as pool tasks. P starts the game and ends up as the best one.
+ * With -s, reports best score against time for each turn.
+ */
+int
+beam(position_t *P)
+{
+	beam_t B;
+	position_t P0;
+	position_t *nP, *tP;
+	bstep_t *hist, *s;
+	bcand_t *top;
+	int *line;
+	lahjob_t J;
+	task_t t;
+	int w = beamw;
+	int turns = baglen + 2;
+	int turn, i, k, n, nn, live, bi;
+	gstats_t st;
+	hrtime_t start, now;
+
+	B.w = w;
+	B.P = (position_t *)malloc(w * sizeof(position_t));
+	nP = (position_t *)malloc(w * sizeof(position_t));
+	B.c = (bcand_t *)malloc((size_t)w * w * sizeof(bcand_t));
+	B.nc = (int *)malloc(w * sizeof(int));
+	top = (bcand_t *)malloc(w * sizeof(bcand_t));
+	hist = (bstep_t *)malloc((size_t)turns * w * sizeof(bstep_t));
+	line = (int *)malloc(turns * sizeof(int));
+	if ((B.P == NULL) || (nP == NULL) || (B.c == NULL) || (B.nc == NULL) ||
+	    (top == NULL) || (hist == NULL) || (line == NULL)) {
+		vprintf(VNORM, "ERROR: no memory for a beam of %d\n", w);
+		free(B.P); free(nP); free(B.c); free(B.nc);
+		free(top); free(hist); free(line);
+		return 0;
+	}
+
+	B.P[0] = *P;
+	B.P[0].sc = -1;
+	B.P[0].state = LOOK;
+	B.P[0].stats = nullstats;
+	B.n = 1;
+	J.P = P;
+	J.run = beamtask;
+	J.arg = &B;
+	J.stats = nullstats;
+	t.J = &J;
+
+	start = gethrtime();
+	for (turn = 0; turn < turns; turn++) {
+		if ((nthreads > 1) && (B.n > 1)) {
+			runjob(&J, B.n, &(P->stats));
+		} else for (t.i = 0; t.i < B.n; t.i++) {
+			beamtask(&t);
+		}
+		n = 0; live = 0;
+		for (i = 0; i < B.n; i++) {
+			addstats(&(P->stats), &(B.P[i].stats));
+			P->stats.evals += B.P[i].stats.evals;
+			B.P[i].stats = nullstats;
+			if (B.P[i].state != DONE) live++;
+			for (k = 0; k < B.nc[i]; k++) {
+				n = bkeep(top, n, w, &(B.c[i * w + k]));
+			}
+		}
+		if (live == 0) break;
+
+		/* make them. the same game got to two ways is kept once. */
+		for (k = 0, nn = 0; k < n; k++) {
+			tP = &(nP[nn]);
+			*tP = B.P[top[k].from];
+			if (tP->state != DONE) {
+				unpackmove(&(tP->b), top[k].cm, &(tP->m));
+				makemove8(&(tP->b), &(tP->m), 1, 0, &(tP->r), NULL);
+				tP->sc += tP->m.score;
+				if (tP->m.score > P->stats.wordhs) P->stats.wordhs = tP->m.score;
+			}
+			for (i = 0; i < nn; i++) {
+				if ((nP[i].b.hash == tP->b.hash) &&
+				    (nP[i].bagndx == tP->bagndx) &&
+				    (nP[i].state == tP->state)) break;
+			}
+			if (i < nn) continue;
+			s = &(hist[turn * w + nn]);
+			s->from = top[k].from;
+			s->m = (tP->state == DONE) ? emptymove : tP->m;
+			s->sc = tP->sc;
+			nn++;
+		}
+		tP = B.P; B.P = nP; nP = tP;
+		B.n = nn;
+		now = gethrtime();
+		STAT(STMED, "beam %d turn %d: best %d, %d live, %llu nsec\n", w, turn, B.P[0].sc, live, now - start);
+	}
+	now = gethrtime();
+
+	/* the winner, and the way it got there. */
+	bi = 0;
+	for (i = 1; i < B.n; i++) {
+		if (B.P[i].sc > B.P[bi].sc) bi = i;
+	}
+	for (k = turn - 1, i = bi; k >= 0; k--) {
+		line[k] = i;
+		i = hist[k * w + i].from;
+	}
+	P0 = *P;
+	P0.sc = -1;
+	for (k = 0; k < turn; k++) {
+		s = &(hist[k * w + line[k]]);
+		if (s->m.tiles[0] == '\0') continue;
+		VERB(VNORM, "beam score is %d for ", s->sc) {
+			printmove(&(s->m), -1);
+		}
+		replay(&P0, &(s->m));
+	}
+	gcgend(&(B.P[bi].r), P0.sc - B.P[bi].sc, B.P[bi].sc);
+	st = P->stats;
+	*P = B.P[bi];
+	P->stats = st;
+	if (P->sc > P->stats.gamehs) P->stats.gamehs = P->sc;
+	STAT(STLOW, "beam %d: score %d in %llu nsec\n", w, P->sc, now - start);
+
+	free(B.P); free(nP); free(B.c); free(B.nc);
+	free(top); free(hist); free(line);
+	return P->sc;
+}
+
+/*
+ * greedy playout from P to the end of the game, like ceo2_b: the best
+ * move every turn. P is played on in place. Nothing is allocated, the
+ * move buffer is the thread's own. Returns the final score.
+ */
+int
+playout(position_t *P)
+{
+	mvbuf_t *mb;
+	int mvsndx, mvcnt;
+
+	mb = mvpush();
+	if (mb == NULL) return P->sc;
+	mb->keep = MV_BEST;
+	for (;;) {
+		fillrack(&(P->r), globalbag, &(P->bagndx));
+		qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+		mvsndx = 0;
+		mvcnt = genall_d(P, mb, &mvsndx);
+		P->stats.moves += mvcnt;
+		if (mvcnt == 0) break;
+		P->sc += veep_b(P, mb->mvs, mvsndx);
+	}
+	P->sc -= unbonus(&(P->r), globalbag, P->bagndx);
+	mvpop(mb);
+	return P->sc;
+}
+
+/* roll out candidate t->i of the job: make it on a copy, play it out. */
+void
+rolltask(task_t *t)
+{
+	roll_t *R = (roll_t *)(t->J->arg);
+	position_t iP;
+	int i;
+
+	i = (R->ord != NULL) ? ORDNDX(R->ord[t->i]) : t->i;
+	iP = *(R->P);
+	iP.stats = nullstats;
+	unpackmove(&(iP.b), R->mvs[i], &(iP.m));
+	makemove8(&(iP.b), &(iP.m), 1, 0, &(iP.r), NULL);
+	iP.sc += iP.m.score;
+	R->vals[t->i] = playout(&iP);
+	__sync_fetch_and_add(&(R->moves), iP.stats.moves);
+}
+
+/*
+ * rollout strategy: every turn, play out each candidate greedily to
+ * the end of the game and make the one that ended best. Ties go to
+ * the first in move order. With -c n only the n best scoring moves
+ * are tried; with -j the rollouts are pool tasks.
+ */
+int
+roll(position_t *P)
+{
+	mvbuf_t *mb, *ob;
+	roll_t R;
+	lahjob_t J;
+	task_t t;
+	int *vals = NULL, *nv;
+	int nvals = 0;
+	int mvsndx, mvcnt, n, k, i, bi, maxv;
+	hrtime_t fore, aft;
+
+	mb = mvpush();
+	if (mb == NULL) return 0;
+	P->sc = -1;
+	R.P = P;
+	J.P = P;
+	J.run = rolltask;
+	J.arg = &R;
+	J.stats = nullstats;
+	t.J = &J;
+	for (;;) {
+		fillrack(&(P->r), globalbag, &(P->bagndx));
+		qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+		mvsndx = 0;
+		mvcnt = genall_d(P, mb, &mvsndx);
+		P->stats.moves += mvcnt;
+		if (mvcnt > P->stats.maxwidth) P->stats.maxwidth = mvcnt;
+		if (mvcnt == 0) break;
+
+		n = mvsndx;
+		ob = NULL;
+		R.ord = NULL;
+		if ((rollc > 0) && (rollc < n)) {
+			ob = mvpush();
+			R.ord = mvorder(ob, mb->mvs, mvsndx);
+			if (R.ord != NULL) n = rollc;
+		}
+		if (n > nvals) {
+			nv = (int *)realloc(vals, n * sizeof(int));
+			if (nv == NULL) {
+				vprintf(VNORM, "ERROR: no memory for %d rollouts\n", n);
+				mvpop(ob);
+				break;
+			}
+			vals = nv;
+			nvals = n;
+		}
+		R.mvs = mb->mvs;
+		R.vals = vals;
+		R.moves = 0;
+		fore = gethrtime();
+		if ((nthreads > 1) && (n > 1)) {
+			runjob(&J, n, &(P->stats));
+		} else for (t.i = 0; t.i < n; t.i++) {
+			rolltask(&t);
+		}
+		aft = gethrtime();
+		P->stats.evtime += aft - fore;
+		P->stats.evals += n;
+		P->stats.moves += R.moves;
+
+		bi = mvsndx; maxv = LOWSCORE;
+		for (k = 0; k < n; k++) {
+			i = (R.ord != NULL) ? ORDNDX(R.ord[k]) : k;
+			if ((vals[k] > maxv) || ((vals[k] == maxv) && (i < bi))) {
+				maxv = vals[k];
+				bi = i;
+			}
+		}
+		mvpop(ob);
+		unpackmove(&(P->b), mb->mvs[bi], &(P->m));
+		gcgmove(&(P->b), &(P->r), P->bagndx, &(P->m), P->sc + P->m.score);
+		makemove8(&(P->b), &(P->m), 1, 0, &(P->r), NULL);
+		P->sc += P->m.score;
+		P->mvndx = bi;
+		P->mvcnt = mvcnt;
+		if (P->m.score > P->stats.wordhs) P->stats.wordhs = P->m.score;
+		VERB(VNORM, "roll score is %d (to %d) for ", P->sc, maxv) {
+			printmove(&(P->m), -1);
+		}
+		STAT(STMED, "%d rollouts in %llu nsec\n", n, aft - fore);
+	}
+	n = unbonus(&(P->r), globalbag, P->bagndx);
+	P->sc -= n;
+	gcgend(&(P->r), n, P->sc);
+	if (P->sc > P->stats.gamehs) P->stats.gamehs = P->sc;
+	free(vals);
+	mvpop(mb);
+	return P->sc;
+}
+
+/*
+ * iterative deepening, one move at a time like creep, but against the
+ * clock. Each turn gets its share of what's left of the --time-budget
+ * and searches levels 0, 1, 2... until time is up, then makes the
+ * first move of the last line that finished. Level 0 always finishes.
+ * Stops going deeper once the line reaches the end of the game, or at
+ * -n if that's set. Without a budget, -n is the only limit.
  */
 int
-lah(position_t *P, int depth, int limit)
+deepen(position_t *P)
 {
-	move_t *mvs = NULL;
-	int mvsndx = 0;
-	position_t *newP, maxP, iP;
-	int maxsc = -1000000;		// lower than any possible score.
-	int i; int rv; int maxrv; int maxi;
-	hrtime_t fore, aft;
-
-	fillrack(&(P->r), globalbag, &(P->bagndx));
-	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
-DBG(DBG_LAH, "enter depth=%d limit=%d rack=", depth, limit) {
-	printlstr(P->r.tiles); printf("\n");
-}
-	P->m = emptymove;
-//	P->mvcnt = genall_b(P, &mvs, &mvsndx);
-//	P->mvcnt = genall_c(P, &mvs, &mvsndx);
-	P->mvcnt = genall_d(P, &mvs, &mvsndx);
-	P->stats.moves += P->mvcnt;
-	if (depth > P->stats.maxdepth) P->stats.maxdepth = depth;
-	if (P->mvcnt > P->stats.maxwidth) P->stats.maxwidth = P->mvcnt;
-
-DBG(DBG_LAH, "[%d]genall gave %d (%d)moves\n",depth, P->mvcnt, mvsndx);
-	if (P->mvcnt == 0) {
-		/* there were no more moves. EOG */
-		P->sc -= unbonus(&(P->r), globalbag, P->bagndx);
-		P->next = NULL;
-		free(mvs); mvsndx = 0;
-		return 0;
-	}
-	if (depth >= limit) {
-ASSERT(mvsndx == P->mvcnt);
-		int score = veep_b(P, mvs, P->mvcnt);
-		P->sc += score;
-		if (score > P->stats.wordhs) P->stats.wordhs = score;
-		P->next = NULL;
-		free(mvs); mvsndx = 0;
-DBG(DBG_LAH, "[%d]veep found (%d) move =", depth, P->sc) {
-	printmove(&(P->m), -1);
-}
-		return 1;
-	}
-	/* still looking ahead. recursive part. */
-	ASSERT(depth < limit);
-	newP = malloc(sizeof(position_t));
-	P->next = newP;
+	position_t tP, bP;
+	position_t *cP;
+	gstats_t st;
+	hrtime_t now, end;
+	int lv, rv, brv, n, left;
 
-	for (i = 0; i < P->mvcnt; i++) {
-DBG(DBG_LAH, "[%d]recurse with move %d=", depth,i) {
-	printmove(&(mvs[i]), -1);
-}
-		iP = *P;
-//		makemove6(&(iP.b), &(mvs[i]), 1, 0, &(iP.r));
-		makemove8(&(iP.b), &(mvs[i]), 1, 0, &(iP.r));
-		iP.m = mvs[i];
-		iP.mvndx = i;
-		iP.sc += iP.m.score;
-		if (iP.m.score > iP.stats.wordhs) iP.stats.wordhs = iP.m.score;
-		*newP = iP; newP->next = NULL;
-		newP->stats.moves = 0;
-		fore = gethrtime();
-		rv = lah(newP, depth+1, limit);
-		aft = gethrtime();
-		newP->stats.evtime = aft - fore;
-//		P->stats.moves += newP->mvcnt;
-		P->stats.moves += newP->stats.moves;
-		
-		P->stats.evtime += newP->stats.evtime;
-		if (newP->stats.maxdepth > P->stats.maxdepth)
-			P->stats.maxdepth = newP->stats.maxdepth;
-		if (newP->sc > maxsc) {
-			maxP = iP;
-			maxsc = newP->sc;
-			maxrv = rv;
-			maxP.mvndx = i;
-		}
-	}
-	// in the case where next move is no move, free maxP.
-	if (maxrv == 0) {
+	P->sc = -1;
+	P->next = NULL;
+	end = gethrtime() + budget;
+	for (;;) {
+		/* about 4 tiles a move */
+		left = (baglen - P->bagndx + strlen(P->r.tiles)) / 4 + 1;
+		now = gethrtime();
+		deadline = 0;
+		if (budget > 0) deadline = (end > now) ? now + (end - now) / left : now;
+		globaldone = 0;
+		for (lv = 0; ; lv++) {
+			tP = *P;
+			tP.stats = nullstats;
+			rv = lah(&tP, 0, lv);
+			addstats(&(P->stats), &(tP.stats));
+			if (globaldone && (lv > 0)) {
+				freechain(tP.next);
+				lv--;
+				break;
+			}
+			if (lv > 0) freechain(bP.next);
+			bP = tP;
+			brv = rv;
+			if (rv == 0) break;
+			for (n = 0, cP = &bP; cP != NULL; cP = cP->next) n++;
+			if (n <= lv) break;
+			if (((budget == 0) || (level > 0)) && (lv >= level)) break;
+		}
+		st = P->stats;
+		if (brv == 0) {
+			/* EOG, bP.sc is already corrected */
+			gcgend(&(bP.r), P->sc - bP.sc, bP.sc);
+			*P = bP;
+			P->stats = st;
+			break;
+		}
+		freechain(bP.next);
+		gcgmove(&(P->b), &(P->r), P->bagndx, &(bP.m), bP.sc);
+		*P = bP;
 		P->next = NULL;
-		free(newP);
+		P->stats = st;
+		P->depth++;
+		VERB(VNORM, "deepen score is %d at level %d for ", P->sc, lv) {
+			printmove(&(P->m), -1);
+		}
 	}
-	*P = maxP;
-//	P->m = mvs[maxi];
-DBG(DBG_LAH, "[%d]returning for score %d/%d/%d with move=", depth, maxsc, maxP.sc, maxP.m.score) {
-	printmove( &(maxP.m), -1);
-	showboard(P->b, B_TILES);
-}
-	free(mvs); mvsndx = 0;
-	return 2;
+	deadline = 0;
+	globaldone = 0;
+	return P->sc;
 }
 
-
 int
 subscore(move_t m, move_t subm)
 {
@@ -3556,7 +6132,7 @@ sp_lookup(letter_t *word)
 				nodeid = 1;
 				continue;
 			}
-			if (gf(gaddag[lid])) {
+			if (gf(gnode(lid))) {
 				/* it's a word. great. */
 				ASSERT(subl > 1);
 				subl = 0;
@@ -3566,15 +6142,15 @@ sp_lookup(letter_t *word)
 				/* not a match */
 				return 0;
 			}
-		} else if (b & bitset[nodeid]) {
+		} else if (b & gbits(nodeid)) {
 			subl++;
 			lid = gotol(l, nodeid);
-			nodeid = gc(gaddag[lid]);
+			nodeid = gc(gnode(lid));
 		} else {
 			return 0;
 		}
 	}
-	if ((subl > 1) && ! gf(gaddag[lid])) {
+	if ((subl > 1) && ! gf(gnode(lid))) {
 		return 0;
 	} 
 	return 1;
@@ -3672,7 +6248,7 @@ verify()
 		v = ALLPHABITS;
 		rv = popc (v << 31);
 		ASSERT(rv == 1);
-		v = bitset[1]; i = 1;
+		v = gbits(1); i = 1;
 		rv = popc (v << (32-1));
 		ASSERT(rv == 1);
 		rv = popc (v << (32-i));
@@ -3827,10 +6403,13 @@ printlstr(tm.tiles); printf("\n");
 		bs = finals(nid);
 vprintf(VNOISY, "finals for node %d are %x\n", nid, bs);
 		ASSERT(bs == 0);
-		nid =126; bs = 0;
-		bs = finals(nid);
+		/* node numbers move with mkgaddag -o */
+		if (dictorder == DO_DFS) {
+			nid =126; bs = 0;
+			bs = finals(nid);
 vprintf(VNOISY, "finals for node %d are %x\n", nid, bs);
-		ASSERT(bs == 1);
+			ASSERT(bs == 1);
+		}
 	}
 	{
 		/* ndn = next door neighbor */
@@ -4285,130 +6864,800 @@ VERB(VVERB, "rv=%d for %d,%d %s pt=%d tiles=", rv, tm.row, tm.col, tm.dir == M_H
 		ASSERT( (l2b(L) & bs));
 	}
 
-	if (verbose != savev) {
-		verbose = savev;
+	if (verbose != savev) {
+		verbose = savev;
+	}
+	vprintf(VVERB, "finished verify!\n");
+}
+#endif /* DEBUG */
+
+#define WS	" \n\t"
+/* if this function retuns NULL, it should not be called again. */
+char *
+getnextarg(int argc, char **argv, int *optind)
+{
+	static char *buf = NULL;
+	char *ap = NULL;
+	/* read file first, if any */
+	if (infile != NULL) {
+		int fd = -1;
+		off_t len;
+		int rv;
+		fd = open(infile, O_RDONLY);
+		infile = NULL;
+		if (fd < 0) {
+			perror("open");
+			goto end;
+		}
+		len = lseek(fd, 0, SEEK_END);
+		if (len < 0) {
+			perror("lseek");
+			goto end;
+		}
+		(void) lseek(fd, 0, SEEK_SET);
+		buf = malloc(len+2);
+		if (buf == NULL) {
+			perror("malloc");
+			goto end;
+		}
+		rv = read(fd, buf, len);
+		if (rv < 0) {
+			perror("read");
+			goto end;
+		} else if (rv != len) {
+			printf("error reading move file, only got %d out of %d bytes\n", rv, (int)len);
+			len = rv;
+		}
+end:
+		infile = NULL;
+		close(fd);
+		if (buf != NULL) {
+			buf[len]='\0';
+			ap = strtok(buf, WS);
+			if (ap == NULL) {
+				free(buf); buf = NULL;
+			} else {
+				return ap;
+			}
+		}
+	}
+	if (buf != NULL) {
+		ap = strtok(NULL, WS);
+		if (ap == NULL) {
+			free(buf);
+			buf = NULL;
+		} else {
+			return ap;
+		}
+	}
+	if (*optind < argc) {
+		ap = argv[*optind];
+		*optind += 1;
+		return ap;
+	}
+	return NULL;
+}
+
+uint32_t
+parsedbg(char *arg)
+{
+	unsigned long rv; char *p;
+	int i; uint32_t flags = 0;
+	errno = 0;
+
+	if(arg == NULL) return flags;
+	rv = strtoul(arg, &p, 16);
+
+	if ((*p == '\0') && (rv != 0) && (errno == 0)) {
+		flags = rv;
+		return flags;
+	}
+	if (strcasecmp(arg, "all") == 0) {
+		flags = DBG_ALL;
+		return flags;
+	}
+	if (strcasecmp(arg, "none") == 0) {
+		flags = 0;
+		return flags;
+	}
+	for (i = 0; i < 32; i++) {
+		if (! strcasecmp(arg, dbgs[i])) {
+			flags |= 0x1LU << i;
+			return flags;
+		}
+	}
+	vprintf(VNORM, "unknown debug option %s\n", arg);
+	return 0;
+}
+
+#define ACT_LOOKUP	0x001
+#define	ACT_ANAGRAM	0x002
+#define ACT_SCORE	0x004
+#define ACT_MOVE	0x008
+#define ACT_PLAYTHRU	0x010
+#define ACT_GEN		0x020
+#define ACT_STRAT	0x040
+#define	ACT_BAGGIT	0x080
+#define ACT_SUBWORD	0x100
+#define ACT_15		0x200
+
+#define STRAT_GREEDY	1
+#define STRAT_GREED2	2
+#define STRAT_GREED2B	3
+#define STRAT_LAH1	4
+#define STRAT_CREEP	5
+#define	STRAT_JUMP	6
+#define STRAT_BEAM	7
+#define STRAT_ROLL	8
+#define STRAT_DEEPEN	9
+
+#define OPT_SEED	0x100	/* --seed, which has no letter */
+#define OPT_BENCH	0x101	/* --bench */
+#define OPT_CORPUS	0x102	/* --corpus */
+#define OPT_GENBENCH	0x103	/* --genbench */
+#define OPT_LAYOUT	0x104	/* --layout */
+#define OPT_DICTMAP	0x105	/* --dictmap */
+
+/* play a game from P with -T strat. returns the score. */
+int
+play(position_t *P)
+{
+	int sc = 0;
+
+	switch (strat) {
+	case STRAT_GREEDY:
+		sc = ceo(&(P->b));
+		break;
+	case STRAT_GREED2:
+		vprintf(VNORM, "GREED2 is defunct\n");
+		break;
+	case STRAT_GREED2B:
+		sc = ceo2_b(&(P->b));
+		break;
+	case STRAT_LAH1: {
+		position_t P0;
+
+		P->sc = -1;
+		P0 = *P;
+		sc = lah(P, 0, level);
+		gcgline(&P0, P);
+		break;
+	}
+	case STRAT_CREEP:
+		sc = creep(P);
+		break;
+	case STRAT_JUMP:
+		sc = jump(P);
+		break;
+	case STRAT_BEAM:
+		sc = beam(P);
+		break;
+	case STRAT_ROLL:
+		sc = roll(P);
+		break;
+	case STRAT_DEEPEN:
+		sc = deepen(P);
+		break;
+	}
+	return sc;
+}
+
+/*
+ * -g: each thread takes the next bag from the list and plays it
+ * through, until there are none left.
+ */
+void *
+batchthread(void *arg)
+{
+	bagjob_t *jobs = arg;
+	bagjob_t *J;
+	position_t P;
+	hrtime_t fore;
+	int n = (batchn == BATCHALL) ? 26 : batchn;
+	int i;
+
+	while ((i = __sync_fetch_and_add(&batchnext, 1)) < n) {
+		J = &(jobs[i]);
+		globalbag = J->bag;
+		baglen = J->len;
+		bagname = J->name;
+		bagtag = J->name[0];
+		bagkey = (uint64_t)bagsum() * 0x9E3779B97F4A7C15ULL;
+		P = startp;
+		P.stats = nullstats;
+		turns = 0;
+		if (gcgfn != NULL) gcgopen();
+		fore = gethrtime();
+		J->score = play(&P);
+		J->time = gethrtime() - fore;
+		gcgclose();
+		J->moves = turns;
+		J->stats = P.stats;
+	}
+	return NULL;
+}
+
+/*
+ * -g: play the strategy on a whole list of bags at once, either
+ * A-Z or n shakes of the base bag. They share the dictionary and
+ * table, and -j of them run at a time, each with one search thread.
+ * Prints a line for each bag. Returns the total score.
+ */
+int
+batch()
+{
+	bagjob_t *jobs;
+	pthread_t tids[MAXTHREADS];
+	int n = (batchn == BATCHALL) ? 26 : batchn;
+	int nt = nthreads;
+	int v = verbose;
+	int i, t, total = 0, moves = 0;
+	hrtime_t time = 0;
+
+	jobs = calloc(n, sizeof(bagjob_t));
+	if (jobs == NULL) {
+		VERB(VNORM, "ERROR: batch ") {
+			perror("calloc");
+		}
+		return 0;
+	}
+	for (i = 0; i < n; i++) {
+		char *bs = (batchn == BATCHALL) ? bags[i] : basebag;
+
+		if (batchn == BATCHALL) {
+			snprintf(jobs[i].name, sizeof(jobs[i].name), "%c", 'A' + i);
+		} else {
+			snprintf(jobs[i].name, sizeof(jobs[i].name), "r%d", batchfirst + i);
+		}
+		jobs[i].len = strlen(bs);
+		jobs[i].bag = strdup(bs);
+		if ((jobs[i].bag == NULL) || casec2lstr(bs, jobs[i].bag) != 0) {
+			vprintf(VNORM, "ERROR: batch bag %s\n", jobs[i].name);
+			while (i >= 0) free(jobs[i--].bag);
+			free(jobs);
+			return 0;
+		}
+		if (batchn != BATCHALL) {
+			shakebag(jobs[i].bag, jobs[i].len, batchfirst + i);
+		}
+	}
+	if (ckfn != NULL) {
+		vprintf(VNORM, "Warning: no checkpoints with -g\n");
+		ckfn = NULL;
+	}
+	/* games are one thread each. They'd all talk at once, too. */
+	if (nt > n) nt = n;
+	nthreads = 1;
+	if (verbose <= VNORM) verbose = VSHH;
+	batchnext = 0;
+	for (t = 1; t < nt; t++) {
+		if (pthread_create(&(tids[t]), NULL, batchthread, jobs) != 0) {
+			VERB(v, "ERROR: batch thread ") {
+				perror("pthread_create");
+			}
+			break;
+		}
+	}
+	batchthread(jobs);
+	while (--t > 0) {
+		pthread_join(tids[t], NULL);
+	}
+	verbose = v;
+	nthreads = nt;
+
+	if (batchn != BATCHALL) {
+		vprintf(VNORM, "--seed %llu\n", seed);
+	}
+	vprintf(VNORM, "bag\tscore\tmoves\tnsec\n");
+	for (i = 0; i < n; i++) {
+		vprintf(VNORM, "%s\t%d\t%d\t%lld\n", jobs[i].name, jobs[i].score, jobs[i].moves, jobs[i].time);
+		total += jobs[i].score;
+		moves += jobs[i].moves;
+		time += jobs[i].time;
+		addstats(&(startp.stats), &(jobs[i].stats));
+		free(jobs[i].bag);
+	}
+	vprintf(VNORM, "total\t%d\t%d\t%lld\n", total, moves, time);
+	free(jobs);
+	return total;
+}
+
+/* nsec to make and unmake a move, over the moves of the game. */
+hrtime_t
+mmbench()
+{
+	board_t b;
+	rack_t r;
+	undo_t u;
+	hrtime_t fore, t = 0;
+	int i, k;
+
+	for (i = 0; i < benchnmv; i++) {
+		b = benchmvs[i].b;
+		fore = gethrtime();
+		for (k = 0; k < BENCHMM; k++) {
+			r = benchmvs[i].r;
+			makemove8(&b, &(benchmvs[i].m), 1, 0, &r, &u);
+			unmakemove(&b, &u);
+		}
+		t += gethrtime() - fore;
+	}
+	if (benchnmv == 0) return 0;
+	return t / ((hrtime_t)benchnmv * BENCHMM);
+}
+
+/* sort, and take the p'th percentile, nearest rank. */
+uint64_t
+pctile(uint64_t *v, int n, int p)
+{
+	int i, j;
+	uint64_t t;
+
+	for (i = 1; i < n; i++) {
+		for (j = i; (j > 0) && (v[j-1] > v[j]); j--) {
+			t = v[j]; v[j] = v[j-1]; v[j-1] = t;
+		}
+	}
+	i = (p * n + 99) / 100 - 1;
+	return v[(i < 0) ? 0 : i];
+}
+
+/*
+ * --bench n: play the game n times, each with a cold table, and
+ * print one csv line of medians and 95th percentiles:
+ * rev,bag,strat,level,prune,threads,reps,score,nsec (med,p95),
+ * move gen ns/move (med,p95), makemove ns (med,p95),
+ * nodes/sec (med,p95). A node is a genall_d call.
+ * The GNUmakefile bench target runs a matrix of these.
+ */
+int
+bench()
+{
+	uint64_t *tot, *gen, *mm, *nps;
+	position_t P;
+	hrtime_t fore, t;
+	int i, sc = 0;
+
+	tot = calloc(4 * benching, sizeof(uint64_t));
+	benchmvs = calloc(BENCHMVS, sizeof(benchmv_t));
+	if ((tot == NULL) || (benchmvs == NULL)) {
+		VERB(VNORM, "ERROR: bench ") {
+			perror("calloc");
+		}
+		free(tot); free(benchmvs);
+		benchmvs = NULL;
+		return 0;
+	}
+	gen = tot + benching;
+	mm = gen + benching;
+	nps = mm + benching;
+	for (i = 0; i < benching; i++) {
+		ttclear();
+		P = startp;
+		P.stats = nullstats;
+		turns = 0;
+		benchnmv = 0;
+		benchgens = benchgmoves = benchgtime = 0;
+		bgens = bgmoves = bgtime = 0;
+		fore = gethrtime();
+		sc = play(&P);
+		t = gethrtime() - fore;
+		benchfold();
+		tot[i] = t;
+		gen[i] = (benchgmoves > 0) ? benchgtime / benchgmoves : 0;
+		nps[i] = (t > 0) ? benchgens * 1000000000ULL / t : 0;
+		mm[i] = mmbench();
+		vprintf(VVERB, "bench %d: score %d in %llu nsec, %llu nodes\n", i, sc, t, benchgens);
+	}
+	printf("%d,%s,%d,%d,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+	    REV, bagname, strat, level, prune, nthreads, benching, sc,
+	    pctile(tot, benching, 50), pctile(tot, benching, 95),
+	    pctile(gen, benching, 50), pctile(gen, benching, 95),
+	    pctile(mm, benching, 50), pctile(mm, benching, 95),
+	    pctile(nps, benching, 50), pctile(nps, benching, 95));
+	free(tot); free(benchmvs);
+	benchmvs = NULL;
+	return sc;
+}
+
+/*
+ * make b the board with letters l on it (0 is empty), by playing each
+ * word they make on a start board, across then down, so makemove8 puts
+ * back the anchors, mls and mbs. Returns -1 if no game could get there:
+ * a word that isn't one, a letter on its own, or nothing on the star.
+ */
+int
+posbuild(board_t *b, letter_t l[BOARDX][BOARDY])
+{
+	move_t m;
+	int dir, i, j, k, n, r, c;
+	int nl = 0;
+
+	*b = startboard;
+	for (dir = M_HORIZ; dir <= M_VERT; dir++) {
+		for (i = 0; i < BOARDSIZE; i++) {
+			for (j = 0; j < BOARDSIZE; j = k + 1) {
+				m = emptymove;
+				for (n = 0, k = j; k < BOARDSIZE; n++, k++) {
+					r = (dir == M_HORIZ) ? i : k;
+					c = (dir == M_HORIZ) ? k : i;
+					if (l[r][c] == '\0') break;
+					m.tiles[n] = l[r][c];
+				}
+				if (n < 2) continue;
+				m.row = (dir == M_HORIZ) ? i : j;
+				m.col = (dir == M_HORIZ) ? j : i;
+				m.dir = dir;
+				if (makemove8(b, &m, 1, 0, NULL, NULL) < 0) return -1;
+			}
+		}
 	}
-	vprintf(VVERB, "finished verify!\n");
+	for (r = 0; r < BOARDX; r++) {
+		for (c = 0; c < BOARDY; c++) {
+			if (b->spaces[r][c].b.f.letter != l[r][c]) return -1;
+			if (l[r][c] != '\0') nl++;
+		}
+	}
+	if ((nl > 0) && (l[STARTR][STARTC] == '\0')) return -1;
+	ASSERT(b->hash == bdhash(b));
+	return 0;
 }
-#endif /* DEBUG */
 
-#define WS	" \n\t"
-/* if this function retuns NULL, it should not be called again. */
-char *
-getnextarg(int argc, char **argv, int *optind)
+/*
+ * read a text position line s into P, and its bag into bag, which has
+ * room for bagsize letters and a null. bag can be NULL. The rest of P
+ * is startp. Returns 0, or -1 if s isn't one.
+ */
+int
+posparse(char *s, position_t *P, bag_t bag, int bagsize)
 {
-	static char *buf = NULL;
-	char *ap = NULL;
-	/* read file first, if any */
-	if (infile != NULL) {
-		int fd = -1;
-		off_t len;
-		int rv;
-		fd = open(infile, O_RDONLY);
-		infile = NULL;
-		if (fd < 0) {
-			perror("open");
-			goto end;
+	letter_t l[BOARDX][BOARDY];
+	char *tok[5], *save, *cp;
+	int i, r = 0, c = 0, e;
+
+	for (i = 0; i < 5; i++) {
+		tok[i] = strtok_r(i ? NULL : s, WS, &save);
+		if (tok[i] == NULL) return -1;
+	}
+	memset(l, 0, sizeof(l));
+	for (cp = tok[0]; *cp != '\0'; cp++) {
+		if (*cp == '/') {
+			if ((c != BOARDY) || (++r >= BOARDX)) return -1;
+			c = 0;
+		} else if (isdigit(*cp)) {
+			e = strtol(cp, &cp, 10);
+			cp--;
+			if ((e < 1) || (c + e > BOARDY)) return -1;
+			c += e;
+		} else if (isalpha(*cp) && (c < BOARDY)) {
+			l[r][c++] = islower(*cp) ? (C2l(*cp) | BB) : C2l(*cp);
+		} else {
+			return -1;
 		}
-		len = lseek(fd, 0, SEEK_END);
-		if (len < 0) {
-			perror("lseek");
-			goto end;
+	}
+	if ((r != BOARDX - 1) || (c != BOARDY)) return -1;
+	*P = startp;
+	if (strcmp(tok[1], "-") != 0) {
+		if ((strlen(tok[1]) > RACKSIZE) || casec2lstr(tok[1], P->r.tiles)) {
+			return -1;
 		}
-		(void) lseek(fd, 0, SEEK_SET);
-		buf = malloc(len+2);
-		if (buf == NULL) {
-			perror("malloc");
-			goto end;
+		qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+	}
+	P->bagndx = atoi(tok[2]);
+	P->sc = atoi(tok[3]);
+	if (bag != NULL) {
+		bag[0] = '\0';
+		if (strcmp(tok[4], "-") != 0) {
+			if ((strlen(tok[4]) > bagsize) || casec2lstr(tok[4], bag)) {
+				return -1;
+			}
 		}
-		rv = read(fd, buf, len);
-		if (rv < 0) {
-			perror("read");
-			goto end;
-		} else if (rv != len) {
-			printf("error reading move file, only got %d out of %d bytes\n", rv, (int)len);
-			len = rv;
+	}
+	return posbuild(&(P->b), l);
+}
+
+/*
+ * read the next position from f, text if not bin, into P and bag as
+ * posparse does. Text skips empty and '#' lines. Returns 1, 0 at the
+ * end of f, or -1 if what's there isn't a position.
+ */
+int
+posload(FILE *f, position_t *P, bag_t bag, int bagsize, int bin)
+{
+	char buf[CORPLINE];
+	char *cp;
+	posrec_t h;
+	int i;
+
+	if (!bin) {
+		do {
+			if (fgets(buf, sizeof(buf), f) == NULL) return 0;
+			for (cp = buf; isspace(*cp); cp++) ;
+		} while ((*cp == '\0') || (*cp == '#'));
+		return (posparse(cp, P, bag, bagsize) < 0) ? -1 : 1;
+	}
+	if (fread(&h, sizeof(h), 1, f) != 1) return 0;
+	if ((h.magic != POSMAGIC) || (h.version != POSVERSION) ||
+	    (h.rack[RACKSIZE] != '\0') || (strlen(h.rack) > RACKSIZE)) {
+		return -1;
+	}
+	if ((bag != NULL) && (h.baglen <= bagsize)) {
+		if ((h.baglen > 0) && (fread(bag, h.baglen, 1, f) != 1)) return -1;
+		bag[h.baglen] = '\0';
+	} else if (fseek(f, h.baglen, SEEK_CUR) != 0) {
+		return -1;
+	}
+	for (i = 0; i < RACKSIZE; i++) {
+		if ((h.rack[i] < 0) || (h.rack[i] == SEP) || !is_rvalid(h.rack[i])) {
+			return -1;
 		}
-end:
-		infile = NULL;
-		close(fd);
-		if (buf != NULL) {
-			buf[len]='\0';
-			ap = strtok(buf, WS);
-			if (ap == NULL) {
-				free(buf); buf = NULL;
-			} else {
-				return ap;
-			}
+	}
+	for (i = 0; i < BOARDX * BOARDY; i++) {
+		if ((h.tiles[i] < 0) || (h.tiles[i] == BB) || !is_bvalid(h.tiles[i])) {
+			return -1;
 		}
 	}
-	if (buf != NULL) {
-		ap = strtok(NULL, WS);
-		if (ap == NULL) {
-			free(buf);
-			buf = NULL;
+	*P = startp;
+	memcpy(P->r.tiles, h.rack, sizeof(h.rack));
+	qsort(P->r.tiles, strlen(P->r.tiles), 1, lcmp);
+	P->bagndx = h.bagndx;
+	P->sc = h.sc;
+	return (posbuild(&(P->b), (letter_t (*)[BOARDY])h.tiles) < 0) ? -1 : 1;
+}
+
+/*
+ * --genbench: read the positions of a --corpus file, text or binary.
+ * Text lines can also be the old form, a rack and the moves that made
+ * the board: "RACK 8H:WORD H7:WORDS ...". Returns how many, or -1 if
+ * the file can't be read. Bad lines are skipped.
+ */
+int
+corpload(char *fn, position_t **Pp)
+{
+	FILE *f;
+	char buf[CORPLINE], tbuf[CORPLINE];
+	char *tok, *save;
+	position_t *P = NULL, *nP;
+	move_t m;
+	uint32_t magic = 0;
+	int n = 0, size = 0, line = 0, bad, bin;
+
+	f = fopen(fn, "r");
+	if (f == NULL) {
+		VERB(VNORM, "ERROR: corpus ") {
+			perror(fn);
+		}
+		return -1;
+	}
+	bin = (fread(&magic, sizeof(magic), 1, f) == 1) && (magic == POSMAGIC);
+	rewind(f);
+	while (n < CORPMAX) {
+		if (n == size) {
+			size = size ? size * 2 : 256;
+			nP = realloc(P, size * sizeof(position_t));
+			if (nP == NULL) {
+				vprintf(VNORM, "ERROR: no memory for %d positions\n", size);
+				break;
+			}
+			P = nP;
+		}
+		line++;
+		if (bin) {
+			bad = posload(f, &(P[n]), NULL, 0, 1);
+			if (bad == 0) break;
+			if (bad < 0) {
+				vprintf(VNORM, "%s: bad position %d, stopped\n", fn, line);
+				break;
+			}
 		} else {
-			return ap;
+			if (fgets(buf, sizeof(buf), f) == NULL) break;
+			strcpy(tbuf, buf);
+			tok = strtok_r(tbuf, WS, &save);
+			if ((tok == NULL) || (tok[0] == '#')) continue;
+			if (strchr(tok, '/') != NULL) {
+				bad = (posparse(buf, &(P[n]), NULL, 0) < 0);
+			} else {
+				P[n] = startp;
+				bad = (strlen(tok) > RACKSIZE) || casec2lstr(tok, P[n].r.tiles);
+				while (!bad && ((tok = strtok_r(NULL, WS, &save)) != NULL)) {
+					m = emptymove;
+					if (parsemove(tok, &m, JUSTPLAY) != 0) {
+						bad = 1;
+						break;
+					}
+					makemove8(&(P[n].b), &m, 1, 0, NULL, NULL);
+				}
+				qsort(P[n].r.tiles, strlen(P[n].r.tiles), 1, lcmp);
+			}
+			if (bad) {
+				vprintf(VNORM, "%s:%d: bad position, skipped\n", fn, line);
+				continue;
+			}
 		}
+		/* the generators want -1 for the first move */
+		if (P[n].b.spaces[STARTR][STARTC].b.f.letter == '\0') P[n].sc = -1;
+		n++;
 	}
-	if (*optind < argc) {
-		ap = argv[*optind];
-		*optind += 1;
-		return ap;
+	fclose(f);
+	*Pp = P;
+	return n;
+}
+
+int
+cmcmp(const void *a, const void *b)
+{
+	cmove_t x = *(const cmove_t *)a;
+	cmove_t y = *(const cmove_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* drop repeats from sorted move list mvs. returns how many are left. */
+int
+cmuniq(cmove_t *mvs, int n)
+{
+	int i, j = 0;
+
+	for (i = 0; i < n; i++) {
+		if ((j == 0) || (mvs[i] != mvs[j-1])) mvs[j++] = mvs[i];
 	}
-	return NULL;
+	return j;
 }
 
-uint32_t
-parsedbg(char *arg)
+/* print the moves that are only in one of two sorted lists. */
+void
+cmdiff(board_t *b, cmove_t *a, int na, cmove_t *c, int nc)
 {
-	unsigned long rv; char *p;
-	int i; uint32_t flags = 0;
-	errno = 0;
+	move_t m;
+	int i = 0, j = 0;
 
-	if(arg == NULL) return flags;
-	rv = strtoul(arg, &p, 16);
+	while ((i < na) || (j < nc)) {
+		if ((j >= nc) || ((i < na) && (a[i] < c[j]))) {
+			unpackmove(b, a[i++], &m);
+			printf("  only d: "); printmove(&m, -1); printf(" %d\n", m.score);
+		} else if ((i >= na) || (c[j] < a[i])) {
+			unpackmove(b, c[j++], &m);
+			printf("  not d: "); printmove(&m, -1); printf(" %d\n", m.score);
+		} else {
+			i++; j++;
+		}
+	}
+}
 
-	if ((*p == '\0') && (rv != 0) && (errno == 0)) {
-		flags = rv;
-		return flags;
+/*
+ * last level cache read misses of this thread so far, from the perf
+ * counters. -1 if there aren't any (not linux, a VM, not allowed).
+ */
+int64_t
+llcmisses()
+{
+#if defined(__linux__)
+	static int fd = -2;
+	struct perf_event_attr pa;
+	uint64_t v;
+
+	if (fd == -2) {
+		memset(&pa, 0, sizeof(pa));
+		pa.size = sizeof(pa);
+		pa.type = PERF_TYPE_HW_CACHE;
+		pa.config = PERF_COUNT_HW_CACHE_LL |
+		    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		pa.exclude_kernel = 1;
+		pa.exclude_hv = 1;
+		fd = syscall(SYS_perf_event_open, &pa, 0, -1, -1, 0);
+		if (fd < 0) {
+			VERB(VVERB, "no LLC miss counter: ") {
+				perror("perf_event_open");
+			}
+		}
 	}
-	if (strcasecmp(arg, "all") == 0) {
-		flags = DBG_ALL;
-		return flags;
+	if ((fd >= 0) && (read(fd, &v, sizeof(v)) == sizeof(v))) {
+		return v;
 	}
-	if (strcasecmp(arg, "none") == 0) {
-		flags = 0;
-		return flags;
+#endif
+	return -1;
+}
+
+/*
+ * --genbench file: check that genall_b and genall_c make the same set of
+ * moves as genall_d on each position of a corpus, then time each of
+ * them alone over the whole corpus, --bench n times over (once
+ * without). One at a time, so none runs on the dictionary paths
+ * another just warmed. Returns the number of move lists that differ.
+ */
+int
+genbench(char *fn)
+{
+	int (*gen[3])(position_t *, mvbuf_t *, int *) = { genall_d, genall_b, genall_c };
+	char *gname[3] = { "genall_d", "genall_b", "genall_c" };
+	uint64_t moves[3] = { 0, 0, 0 };
+	uint64_t umoves[3] = { 0, 0, 0 };	/* repeats dropped, all reps */
+	uint64_t llc[3] = { 0, 0, 0 };
+	int64_t llc0;
+	hrtime_t t[3] = { 0, 0, 0 };
+	hrtime_t fore;
+	position_t *P = NULL, Q;
+	mvbuf_t *mb;
+	cmove_t *ref = NULL, *nref;
+	int reps = (benching > 0) ? benching : 1;
+	int n, i, g, k, nref0 = 0, nmv, diffs = 0;
+
+	n = corpload(fn, &P);
+	if (n <= 0) {
+		vprintf(VNORM, "no positions in %s\n", fn);
+		free(P);
+		return (n < 0) ? 1 : 0;
+	}
+	mb = mvpush();
+	if (mb == NULL) {
+		free(P);
+		return 1;
 	}
-	for (i = 0; i < 32; i++) {
-		if (! strcasecmp(arg, dbgs[i])) {
-			flags |= 0x1LU << i;
-			return flags;
+	/* check, untimed. it warms things up for all three, too */
+	for (i = 0; i < n; i++) {
+		for (g = 0; g < 3; g++) {
+			Q = P[i];
+			(void) gen[g](&Q, mb, &nmv);
+			/* b and c find a move once per anchor it covers */
+			qsort(mb->mvs, nmv, sizeof(cmove_t), cmcmp);
+			nmv = cmuniq(mb->mvs, nmv);
+			umoves[g] += (uint64_t)nmv * reps;
+			if (g == 0) {
+				nref = realloc(ref, (nmv + 1) * sizeof(cmove_t));
+				if (nref == NULL) {
+					vprintf(VNORM, "ERROR: no memory for %d moves\n", nmv);
+					mvpop(mb); free(P); free(ref);
+					return 1;
+				}
+				ref = nref;
+				memcpy(ref, mb->mvs, nmv * sizeof(cmove_t));
+				nref0 = nmv;
+			} else if ((nmv != nref0) ||
+			    (memcmp(ref, mb->mvs, nmv * sizeof(cmove_t)) != 0)) {
+				diffs++;
+				vprintf(VNORM, "position %d: %s made %d different moves, genall_d %d\n", i + 1, gname[g], nmv, nref0);
+				VERB(VVERB, "") {
+					cmdiff(&(P[i].b), ref, nref0, mb->mvs, nmv);
+				}
+			}
 		}
 	}
-	vprintf(VNORM, "unknown debug option %s\n", arg);
-	return 0;
+	for (g = 0; g < 3; g++) {
+		for (k = 0; k < reps; k++) {
+			for (i = 0; i < n; i++) {
+				Q = P[i];
+				llc0 = llcmisses();
+				fore = gethrtime();
+				(void) gen[g](&Q, mb, &nmv);
+				t[g] += gethrtime() - fore;
+				if (llc0 >= 0) llc[g] += llcmisses() - llc0;
+				moves[g] += nmv;
+			}
+		}
+	}
+	mvpop(mb);
+	vprintf(VNORM, "dictionary layout %s\n", (gshift) ? "paired" : "split");
+	/* rates are of unique moves: all three repeat some, d the most */
+	for (g = 0; g < 3; g++) {
+		vprintf(VNORM, "%s: %d positions, %llu moves (%llu unique) in %llu nsec, %llu moves/sec",
+		    gname[g], n * reps, moves[g], umoves[g], t[g],
+		    (t[g] > 0) ? umoves[g] * 1000000000ULL / t[g] : 0);
+		if (llcmisses() >= 0) {
+			vprintf(VNORM, ", %llu LLC misses/1000 moves",
+			    (umoves[g] > 0) ? llc[g] * 1000 / umoves[g] : 0);
+		}
+		vprintf(VNORM, "\n");
+	}
+	if (diffs) {
+		vprintf(VNORM, "%d move lists differ from genall_d\n", diffs);
+	} else {
+		vprintf(VNORM, "all move lists match\n");
+	}
+	free(P); free(ref);
+	return diffs;
 }
 
-#define ACT_LOOKUP	0x001
-#define	ACT_ANAGRAM	0x002
-#define ACT_SCORE	0x004
-#define ACT_MOVE	0x008
-#define ACT_PLAYTHRU	0x010
-#define ACT_GEN		0x020
-#define ACT_STRAT	0x040
-#define	ACT_BAGGIT	0x080
-#define ACT_SUBWORD	0x100
-#define ACT_15		0x200
-
-#define STRAT_GREEDY	1
-#define STRAT_GREED2	2
-#define STRAT_GREED2B	3
-#define STRAT_LAH1	4
-#define STRAT_CREEP	5
-#define	STRAT_JUMP	6
-
 int
 main(int argc, char **argv)
 {
@@ -4425,9 +7674,19 @@ main(int argc, char **argv)
 	uint64_t evals = 0;
 /* letters left for options
  * . . C . E F . H . J K . . N O . Q . . . U V W X Y Z
- * a . c . e f g h i j k l m . . p . r . . u . w x y z
+ * a . . . . f . . i . . l m . . . . . . . u . . . . .
  */
-        while ((c = getopt(argc, argv, "LASMGPI:T:n:b:B:D:vqstd:o:R:xyz")) != -1) {
+	static struct option longopts[] = {
+		{ "time-budget", required_argument, NULL, 'e' },
+		{ "seed", required_argument, NULL, OPT_SEED },
+		{ "bench", required_argument, NULL, OPT_BENCH },
+		{ "corpus", required_argument, NULL, OPT_CORPUS },
+		{ "genbench", required_argument, NULL, OPT_GENBENCH },
+		{ "layout", required_argument, NULL, OPT_LAYOUT },
+		{ "dictmap", required_argument, NULL, OPT_DICTMAP },
+		{ NULL, 0, NULL, 0 }
+	};
+        while ((c = getopt_long(argc, argv, "LASMGPI:T:n:pw:c:e:k:rj:h:b:B:D:vqstd:o:R:g:xyz", longopts, NULL)) != -1) {
                 switch(c) {
 		case 'x':
 			action |= ACT_15;
@@ -4441,6 +7700,51 @@ main(int argc, char **argv)
 		case 'n':
 			level = atoi(optarg);
 			break;
+		case 'p':
+			prune = 1;
+			break;
+		case 'c':
+			rollc = atoi(optarg);
+			if (rollc < 0) {
+				vprintf(VNORM, "rollout count must be >= 0\n");
+				return 1;
+			}
+			break;
+		case 'e':
+			/* check before the cast: hrtime_t is unsigned */
+			if (!(atof(optarg) * 1000000000.0 >= 1.0)) {
+				vprintf(VNORM, "time budget must be > 0 seconds\n");
+				return 1;
+			}
+			budget = (hrtime_t)(atof(optarg) * 1000000000.0);
+			break;
+		case 'k':
+			ckfn = optarg;
+			break;
+		case 'r':
+			ckresume = 1;
+			break;
+		case 'w':
+			beamw = atoi(optarg);
+			if ((beamw < 1) || (beamw > MAXBEAM)) {
+				vprintf(VNORM, "beam width must be 1-%d\n", MAXBEAM);
+				return 1;
+			}
+			break;
+		case 'j':
+			nthreads = atoi(optarg);
+			if ((nthreads < 1) || (nthreads > MAXTHREADS)) {
+				vprintf(VNORM, "threads must be 1-%d\n", MAXTHREADS);
+				return 1;
+			}
+			break;
+		case 'h':
+			ttmb = atoi(optarg);
+			if (ttmb < 0) {
+				vprintf(VNORM, "table size must be >= 0 MB\n");
+				return 1;
+			}
+			break;
 		case 't':
 			dotimes = 1;
 #ifdef DEBUG
@@ -4500,12 +7804,82 @@ DBG(DBG_DBG, "set dflags to 0x%lX\n", dflags);
 		case 'o':
 			gcgfn = optarg;
 			break;
+		case OPT_BENCH:
+			benching = atoi(optarg);
+			if (benching < 1) {
+				vprintf(VNORM, "bench must play >= 1 games\n");
+				return 1;
+			}
+			break;
+		case OPT_CORPUS:
+			corpfn = optarg;
+			break;
+		case OPT_GENBENCH:
+			genfn = optarg;
+			break;
+		case OPT_LAYOUT:
+			if (strcmp(optarg, "split") == 0) {
+				layout = LAYOUT_SPLIT;
+			} else if (strcmp(optarg, "paired") == 0) {
+				layout = LAYOUT_PAIRED;
+			} else {
+				vprintf(VNORM, "--layout is split or paired\n");
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case OPT_DICTMAP:
+			for (word = strtok(optarg, ","); word != NULL; word = strtok(NULL, ",")) {
+				if (strcmp(word, "huge") == 0) {
+					dmflags |= DM_HUGE;
+				} else if (strcmp(word, "populate") == 0) {
+					dmflags |= DM_POPULATE;
+				} else if (strcmp(word, "lock") == 0) {
+					dmflags |= DM_LOCK;
+				} else {
+					vprintf(VNORM, "--dictmap takes huge, populate and lock\n");
+					usage(argv[0]);
+					return 1;
+				}
+			}
+			word = NULL;
+			break;
+		case OPT_SEED:
+			seed = strtoull(optarg, NULL, 0);
+			seeded = 1;
+			break;
+		case 'g':
+			if (strcmp(optarg, "all") == 0) {
+				batchn = BATCHALL;
+			} else {
+				char *dash = strchr(optarg, '-');
+
+				batchn = atoi(optarg);
+				if (dash != NULL) {
+					batchfirst = batchn;
+					batchn = atoi(dash + 1) - batchfirst + 1;
+				}
+				if ((batchn < 1) || (batchfirst < 1)) {
+					vprintf(VNORM, "batch must be all, n or m-n, from 1 up\n");
+					return 1;
+				}
+			}
+			break;
 		default:
 			usage(argv[0]);
 			return 1;
 		}
 	}
 	/* validate options. */
+	/* only creep checkpoints. the others would quietly ignore it */
+	if ((ckfn != NULL) && (strat != STRAT_CREEP)) {
+		vprintf(VNORM, "-k checkpoints only strategy %d, not %d\n", STRAT_CREEP, strat);
+		return 1;
+	}
+	if (ckresume && (ckfn == NULL)) {
+		vprintf(VNORM, "-r needs -k file to restart from\n");
+		return 1;
+	}
 	/* when we have more. bag and dict option are done below */
 	if (getdict(dfn) <= 0) {
 		vprintf(VNORM, "Dictionary disaster.\n");
@@ -4577,7 +7951,7 @@ DBG(DBG_MAIN, "actions %d on arg %s\n", action, argstr);
 		}
 		if (action&ACT_MOVE) {
 //			makemove6(&sb, &argmove, action&ACT_PLAYTHRU, 0, NULL);
-			makemove8(&sb, &argmove, action&ACT_PLAYTHRU, 0, NULL);
+			makemove8(&sb, &argmove, action&ACT_PLAYTHRU, 0, NULL, NULL);
 			VERB(VNORM, "results of move:\n") {
 				showboard(sb, B_TILES);
 			}
@@ -4592,82 +7966,94 @@ DBG(DBG_MAIN, "actions %d on arg %s\n", action, argstr);
 			}
 		}
 		if (action & ACT_GEN) {
-			move_t *mvs = NULL;
+			mvbuf_t *mb = mvpush();
 			int mvsndx = 0;
 			position_t gP = startp;
 			strcpy(gP.r.tiles, argmove.tiles);
 			gP.m = argmove;
 			gP.m.tiles[0] = '\0';
 			qsort(gP.r.tiles, strlen(gP.r.tiles), 1, lcmp);
-			moves = genall_b(&gP, &mvs, &mvsndx);
+			moves = genall_b(&gP, mb, &mvsndx);
 			VERB(VVERB, "moves:") {
 				int i;
+				move_t m;
 				for (i = 0; i< mvsndx; i++) {
-					printmove(&(mvs[i]), -1);
+					unpackmove(&(gP.b), mb->mvs[i], &m);
+					printmove(&m, -1);
 				}
 			}
 			vprintf(VNORM, "gen %d moves from %s\n", moves, argstr);
-			free(mvs);
+			mvpop(mb);
 		}
 	} /* end while args */
 
 	/* these actions don't need move args, they use bags and racks. */
-	if (action&ACT_STRAT) {
-		switch (strat) {
-		case STRAT_GREEDY:
-			if (dotimes) start = gethrtime();
-			totalscore = ceo(&sb);
-			if (dotimes) end = gethrtime();
-			VERB(VVERB, "final board:\n") {
-				showboard(sb, B_TILES);
-			}
-			break;
-		case STRAT_GREED2:
-			vprintf(VNORM, "GREED2 is defunct\n");
-			break;
-		case STRAT_GREED2B:
-			if (dotimes) start = gethrtime();
-			totalscore = ceo2_b(&sb);
-			if (dotimes) end = gethrtime();
-			VERB(VVERB, "final board:\n") {
-				showboard(sb, B_TILES);
+	if ((action&ACT_STRAT) && (ttmb > 0)) {
+		ttinit(ttmb);
+	}
+	if ((action&ACT_STRAT) && (gcgfn != NULL) && (batchn == 0) && (benching == 0)) {
+		gcgopen();
+	}
+	if ((action&ACT_STRAT) && (corpfn != NULL)) {
+		corpbin = (strlen(corpfn) > 4) &&
+		    (strcmp(corpfn + strlen(corpfn) - 4, ".bin") == 0);
+		corpf = fopen(corpfn, "a");
+		if (corpf == NULL) {
+			VERB(VNORM, "ERROR: corpus ") {
+				perror(corpfn);
 			}
-			break;
-		case STRAT_LAH1:
-			startp.sc = -1;
-			if (dotimes) start = gethrtime();
-			totalscore = lah(&startp, 0, level);
-			if (dotimes) end = gethrtime();
-			VERB(VVERB, "final board:\n") {
-				showboard(startp.b, B_TILES);
-			}
-			break;
-		case STRAT_CREEP:
-			if (dotimes) start = gethrtime();
-			totalscore = creep(&startp);
-			if (dotimes) end = gethrtime();
-			VERB(VVERB, "final board:\n") {
-				showboard(startp.b, B_TILES);
-			}
-			break;
-		case STRAT_JUMP:
-			if (dotimes) start = gethrtime();
-			totalscore = jump(&startp);
-			if (dotimes) end = gethrtime();
-			VERB(VVERB, "final board:\n") {
-				showboard(startp.b, B_TILES);
-			}
-			break;
+		}
+	}
+	if (genfn != NULL) {
+		errs += genbench(genfn);
+	}
+	if ((action&ACT_STRAT) && (benching > 0)) {
+		if (dotimes) start = gethrtime();
+		totalscore = bench();
+		if (dotimes) end = gethrtime();
+	} else if ((action&ACT_STRAT) && (batchn != 0)) {
+		if (dotimes) start = gethrtime();
+		totalscore = batch();
+		if (dotimes) end = gethrtime();
+	} else if (action&ACT_STRAT) {
+		if (dotimes) start = gethrtime();
+		totalscore = play(&startp);
+		if (dotimes) end = gethrtime();
+		VERB(VVERB, "final board:\n") {
+			showboard(startp.b, B_TILES);
+		}
+	}
+	gcgclose();
+	if ((corpf != NULL) && (fclose(corpf) != 0)) {
+		VERB(VNORM, "ERROR: corpus ") {
+			perror(corpfn);
 		}
 	}
 	if (dotimes) {
 		totaltime = end - start;
 vprintf(VNORM, "elapsed time is %lld nsec (%lld sec)\n", totaltime, totaltime/1000000000);
 	}
-	STAT(STLOW, "%llu moves in %llu nsec = %llu ns/m\n", startp.stats.moves, startp.stats.evtime,  startp.stats.evtime / startp.stats.moves);
+	/* no moves counted for strategies that don't look ahead */
+	STAT(STLOW, "%llu moves in %llu nsec = %llu ns/m\n", startp.stats.moves, startp.stats.evtime,
+	    (startp.stats.moves > 0) ? startp.stats.evtime / startp.stats.moves : 0);
+	if (ttab) {
+		STAT(STLOW, "table: %llu hits, %llu misses, %llu of %llu entries used\n", startp.stats.tthits, startp.stats.ttmisses, ttused(), (ttmask + 1) * TTWAYS);
+	}
+	if (prune) {
+		STAT(STLOW, "pruned: %llu look-ahead leaves\n", startp.stats.cuts);
+	}
 	if (totalscore > 0)
 		vprintf(VNORM, "total score is %d\n", totalscore);
-vprintf(VVERB, "global move count = %lu\n", gmcnt);
+vprintf(VVERB, "global move count = %lu\n", gmcnt + wmcnt);
+	if (poolsize > 0) {
+		int t;
+		for (t = 0; t <= poolsize; t++) {
+			STAT(STLOW, "thread %d: %llu steals, %llu idle\n", t, tstats[t].steals, tstats[t].idles);
+		}
+	}
+#ifdef DICTPROF
+	if (dprofsave((dfn != NULL) ? dfn : DDFN) < 0) errs++;
+#endif
 	if (errs) {
 		return -errs;
 	} else {
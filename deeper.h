@@ -144,6 +144,76 @@ char coltags[BOARDX+1] = "ABCDEFGHIJKLMNO";
 typedef uint32_t gn_t;		// gaddag node
 typedef uint32_t bs_t;		// bitset
 
+/*
+ * name.dict: the gaddag, its bitset, and whatever else, in one file.
+ * This header, then the sections, each on a DICTALIGN boundary. crc is
+ * of the header with crc 0, and each section has its own. bom is
+ * DICTBOM as written, so a file from a machine with the other byte
+ * order shows up. mkgaddag makes these.
+ */
+#define DICTEND		".dict"
+#define DICTMAGIC	0x49445044	/* "DPDI" */
+#define DICTVERSION	1
+#define DICTBOM		0x01020304
+#define DICTALIGN	4096
+#define DICTSECTS	8
+#define DS_NONE		0
+#define DS_GADDAG	1		/* gn_t[nodes] */
+#define DS_BITSET	2		/* bs_t[nodes] */
+#define DS_PAIRED	3		/* gnbs_t[nodes], mkgaddag -p */
+#define DO_DFS		0		/* depth first, as makegaddag.py did */
+#define DO_BFS		1		/* breadth first, a level at a time */
+#define DO_VEB		2		/* van Emde Boas, split by depth */
+#define DO_HOT		3		/* bfs over what a profile saw used first */
+
+typedef struct Dictsect {
+	uint32_t type;
+	uint32_t crc;
+	uint64_t off;			/* from the start of the file */
+	uint64_t len;			/* in bytes */
+} dictsect_t;
+
+typedef struct Dicthead {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bom;
+	uint32_t crc;
+	uint32_t nodes;			/* gaddag entries */
+	uint32_t words;			/* in the lexicon it came from */
+	uint32_t nsects;
+	uint32_t order;			/* DO_, how mkgaddag numbered the nodes */
+	dictsect_t sect[DICTSECTS];
+} dicthead_t;
+
+/*
+ * --layout: where a node's bitset lives. Split, gaddag and bitset are
+ * arrays of their own, and a step down the gaddag touches both. Paired,
+ * each node sits next to its bitset in one array of gnbs_t, so it's one
+ * cache line. gaddag and bitset then point into the pairs, and gshift
+ * doubles the index. Always go through gnode() and gbits().
+ */
+#define LAYOUT_SPLIT	0
+#define LAYOUT_PAIRED	1
+typedef struct Gnbs {
+	gn_t n;
+	bs_t bs;
+} gnbs_t;
+#ifdef DICTPROF
+/* deeper-dprof counts every look at a node, for mkgaddag -o hot. */
+#define gnode(n)	(gaddag[dprofhit(n) << gshift])
+#define gbits(n)	(bitset[dprofhit(n) << gshift])
+#define PROFEND		".prof"
+#else
+#define gnode(n)	(gaddag[(n) << gshift])
+#define gbits(n)	(bitset[(n) << gshift])
+#endif
+
+/* --dictmap: how to map the dictionary on linux. Each falls back. */
+#define DM_HUGE		0x01	/* copy to huge pages: hugetlb, else THP */
+#define DM_POPULATE	0x02	/* MAP_POPULATE the file maps */
+#define DM_LOCK		0x04	/* mlock what's used */
+#define HUGESZ		(2UL * 1024 * 1024)
+
 #define	ROOTID	1		// everything in gaddag starts here...
 #define	NULLID	0		// and ends here.
 
@@ -312,6 +382,7 @@ typedef struct Space {
  */
 typedef struct Board {
 	space_t spaces[BOARDX][BOARDY];
+	uint64_t hash;		/* zobrist of the letters, kept by makemove8 */
 } board_t;
 
 #define	B_NONE		0
@@ -369,9 +440,75 @@ typedef struct Move {
 	letter_t tiles[BOARDSIZE+1];	// letters to play.
 } move_t;
 
+/*
+ * packed candidate move, what the generators put in move lists.
+ * Only tiles played from the rack are kept, the rest of the word is
+ * on the board it was generated for, so unpack against that board.
+ * Score is on top, so bigger means better.
+ *   bits 0-34	rack tiles, 5 bits each, first one lowest. 0 ends them
+ *   bits 35-41	blank mask, bit n for tile n
+ *   bit 42	direction
+ *   bits 43-50	start square, row * BOARDSIZE + col
+ *   bits 51-63	score
+ */
+typedef uint64_t cmove_t;
+
+#define CM_TILE(cm,n)	((letter_t)(((cm) >> (5 * (n))) & 0x1F))
+#define CM_BLANK(cm,n)	(((cm) >> (35 + (n))) & 1)
+#define CM_DIR(cm)	((int)(((cm) >> 42) & 1))
+#define CM_SQ(cm)	((int)(((cm) >> 43) & 0xFF))
+#define CM_SCORE(cm)	((int)((cm) >> 51))
+#define CM_MAXSCORE	0x1FFF
+
+/*
+ * a move list for the generators. Kept and reused, never zeroed;
+ * grows when a position has more moves than fit. With keep set, only
+ * the best move so far is kept, in mvs[0], and anchors that can't beat
+ * it are skipped.
+ */
+typedef struct Mvbuf {
+	cmove_t *mvs;		/* the moves */
+	int size;		/* room for this many */
+	int keep;		/* MV_ALL or MV_BEST */
+	int ank;		/* anchor being generated, in board order */
+	int bestank;		/* and the one mvs[0] came from */
+	int floor;		/* MV_BEST: moves must beat this to matter */
+	int cut;		/* anchors skipped because of floor */
+	int nank;		/* MV_BEST: anchors there were */
+	int nsearch;		/* and how many were searched */
+} mvbuf_t;
+
+#define MV_ALL	0
+#define MV_BEST	1
+
+/*
+ * -p tries look-ahead children best score first. The sort key is the
+ * score over the move's index, upside down so ties stay in move order.
+ */
+#define ORDKEY(sc, i)	(((uint64_t)(sc) << 32) | (0xFFFFFFFFu - (uint32_t)(i)))
+#define ORDNDX(k)	((int)(0xFFFFFFFFu - (uint32_t)(k)))
+#define LOWSCORE	(-1000000)	/* lower than any possible score */
+
 #define	M_HORIZ	0
 #define	M_VERT	1
 
+/*
+ * undo log for makemove8: the old letter/mls/anchor and mbs of every
+ * space the move touched, in the order they were touched. Unmaking
+ * puts them back last first. 7 tiles, each with a cross word that
+ * can touch 2 spaces at each end, plus the move's own ends.
+ */
+#define MAXUNDO	64
+typedef struct Undo {
+	int n;			/* spaces saved */
+	uint64_t hash;		/* board hash before the move */
+	struct {
+		uint8_t r, c;
+		subspace_t b;
+		bs_t mbs[2];
+	} s[MAXUNDO];
+} undo_t;
+
 /* position states. WORK IN PROGRESS May need bits instead. */
 typedef enum pstate {
 	NEW,		// just created, all blank.
@@ -395,6 +532,11 @@ typedef struct Gstats {
 	int maxwidth;		/* move moves for a position */
 	int wordhs;		/* highest 1-word score */
 	int gamehs;		/* highest game score so far */
+	uint64_t steals;	/* tasks taken from other threads */
+	uint64_t idles;		/* looked for work, found none */
+	uint64_t tthits;	/* transposition table hits */
+	uint64_t ttmisses;	/* and misses */
+	uint64_t cuts;		/* look-ahead leaves cut short by -p */
 } gstats_t;
 
 /* position: basically a snapshot of game state. */
@@ -403,6 +545,7 @@ typedef struct Position {
 	move_t m;		/* current move */
 	rack_t r;		/* what to play with */
 	int sc;			/* total of all move scores */
+	int best;		/* sc at the end of the look-ahead line */
 	int bagndx;		/* aka how many tiles used so far */
 	int mvndx;		/* which move are we */
 	int mvcnt;		/* direct children in game tree */
@@ -413,6 +556,183 @@ typedef struct Position {
 	gstats_t stats;		/* for perf and wow factor */
 } position_t;
 
+/*
+ * transposition table for lah. Key is zobrist over board letters,
+ * rack and bag index. The key is stored xor the data, so a torn write
+ * from another thread just looks like a miss.
+ * data is remaining score:32 | levels searched + 1:8, so 0 is empty.
+ */
+typedef struct TTent {
+	uint64_t kx;		/* key ^ data */
+	uint64_t data;
+} ttent_t;
+
+#define TTWAYS	2		/* entries per bucket */
+#define TTPACK(sc, lv)	((((uint64_t)(uint32_t)(sc))<<32) | ((uint64_t)((lv)+1) & 0xFF))
+#define TTSC(d)		((int32_t)((d)>>32))
+#define TTLV(d)		((int)((d) & 0xFF) - 1)
+
+/* threads. main counts as one of them. */
+#define MAXTHREADS	64
+
+/*
+ * split node: the children of one lah() position, searched as tasks
+ * by whichever threads get to them. Best result and stats are reduced
+ * here, under the job's own lock.
+ */
+struct Task;
+
+typedef struct Lahjob {
+	position_t *P;		/* parent. read only while job runs */
+	void (*run)(struct Task *);	/* not a split: run tasks with this */
+	void *arg;		/* for run */
+	bag_t bag;		/* owner's bag, for the threads that help */
+	int baglen;
+	uint64_t bagkey;
+	hrtime_t deadline;	/* and its deadline */
+	cmove_t *mvs;		/* moves to try from P */
+	uint64_t *ord;		/* order to try them in, or NULL */
+	int floor;		/* P's value has to beat this to matter */
+	int depth;		/* of P */
+	int limit;		/* look-ahead limit */
+	volatile int pending;	/* children not finished yet */
+	pthread_mutex_t lock;	/* for the reduction */
+	int maxsc;		/* best child value so far */
+	int maxi;		/* and which child it was */
+	gstats_t stats;		/* summed over all children */
+} lahjob_t;
+
+/* one child of a split node. */
+typedef struct Task {
+	lahjob_t *J;		/* job it belongs to */
+	int i;			/* index into J->mvs */
+} task_t;
+
+/*
+ * beam search (-T 7). Each turn every entry offers its best few
+ * moves, ranked by score plus leave, and the best w of all of those
+ * are made to get the next beam. Steps are kept to print the winner.
+ * There are w * w candidates, so w is kept to MAXBEAM.
+ */
+#define MAXBEAM		4096
+typedef struct Bcand {
+	int rank;		/* what's sorted on, bigger is better */
+	int from;		/* beam entry it comes from */
+	cmove_t cm;		/* move to make there. unused if game over */
+} bcand_t;
+
+typedef struct Bstep {
+	int from;		/* entry it came from, in the turn before */
+	move_t m;		/* what it played, emptymove if nothing */
+	int sc;			/* total after it */
+} bstep_t;
+
+typedef struct Beam {
+	int w;			/* width */
+	int n;			/* entries in use */
+	position_t *P;		/* the entries. DONE when game is over */
+	bcand_t *c;		/* w candidates for each entry */
+	int *nc;		/* how many each one has */
+} beam_t;
+
+/*
+ * rollouts (-T 8): each candidate move is valued by playing the game
+ * out greedily after it. One task per candidate.
+ */
+typedef struct Roll {
+	position_t *P;		/* where the candidates are from */
+	cmove_t *mvs;		/* the candidates */
+	uint64_t *ord;		/* the ones to try, best score first, or NULL */
+	int *vals;		/* final score of each rollout, by task */
+	uint64_t moves;		/* generated in all rollouts */
+} roll_t;
+
+/*
+ * checkpoint file (-k): this header, then the moves of the game so far
+ * as move_t's. Restarting (-r) replays them on a fresh game. k > 0
+ * means the root search of the next turn was part way: children before
+ * k are done, and the best so far is maxsc, from child maxi.
+ */
+#define CKMAGIC		0x4B435044	/* "DPCK" */
+#define CKVERSION	1
+#define CKSECS		5		/* seconds between checkpoints */
+#define GCGBUF		(64 * 1024)	/* -o file buffer */
+
+typedef struct Ckhead {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bagsum;	/* of the bag, which has to match */
+	int32_t strat;		/* and so do these */
+	int32_t level;
+	int32_t prune;
+	int32_t nmoves;		/* moves that follow */
+	int32_t limit;		/* of the part way search */
+	int32_t k;		/* next child to try */
+	int32_t maxsc;		/* best child value so far */
+	int32_t maxi;		/* and which one */
+	gstats_t stats;
+} ckhead_t;
+
+/* -g: one bag of a batch, and how it went */
+#define BATCHALL	-1		/* -g all: bags A-Z */
+typedef struct Bagjob {
+	char name[16];
+	bag_t bag;
+	int len;
+	int score;
+	int moves;
+	hrtime_t time;
+	gstats_t stats;
+} bagjob_t;
+
+/* --bench: a move of the game, and the board and rack it was made from */
+#define BENCHMVS	128		/* more than a game can have */
+#define BENCHMM		1000		/* times to make and unmake each */
+typedef struct Benchmv {
+	board_t b;
+	rack_t r;
+	move_t m;
+} benchmv_t;
+
+/* --corpus and --genbench position lines */
+#define CORPLINE	4096
+#define CORPMAX		100000		/* positions read */
+
+/*
+ * position files. Text is one line: the board as 15 rows split by '/',
+ * a number for a run of empty squares, lowercase for a blank, then the
+ * rack ('?' blank), bagndx, score and the bag, '-' if no rack or bag:
+ *   15/15/15/15/15/15/15/7OPIATE1/15/15/15/15/15/15/15 ADEIRT? 14 18 AIO...
+ * Binary is this header, then baglen bag letters. Native byte order.
+ * Loading puts the letters back as words, so anchors, mls and mbs are
+ * the same as if the game had been played to get there.
+ */
+#define POSMAGIC	0x534F5044	/* "DPOS" */
+#define POSVERSION	1
+#define POSBAG		1024		/* longest bag kept */
+
+typedef struct Posrec {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t baglen;
+	int32_t sc;
+	int32_t bagndx;
+	letter_t rack[RACKSIZE+1];
+	letter_t tiles[BOARDX*BOARDY];	/* row by row, 0 is empty */
+} posrec_t;
+
+/*
+ * per thread task deque. Owner pushes and pops at the bottom,
+ * thieves take from the top. Ring buffer, so top/bot just count up.
+ */
+#define DQSIZE	4096
+typedef struct Deque {
+	pthread_mutex_t lock;
+	volatile unsigned int top;	/* oldest task */
+	volatile unsigned int bot;	/* next free slot */
+	task_t t[DQSIZE];
+} deque_t;
+
 
 
 /* internal use for keeping running score during movegen. */
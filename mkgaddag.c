@@ -0,0 +1,716 @@
+
+/* build ENABLE.dict straight from a word list. */
+/* Does what dos2unix|tr|grep|gaddagize|sort|makegaddag.py|mkbitset did. */
+/* usage: mkgaddag [-s] [-p] [-o order] [-P prof] [lexicon [name]]. -s also */
+/* writes name.gaddag and name.bitset, the old separate files. -p adds the */
+/* paired layout. -o picks where the nodes go, see reorder(). */
+
+/*
+ * Every word of n letters goes in n times: the first i letters reversed,
+ * then SEP and the rest (no SEP when i is n). Those get sorted, so the
+ * trie can be minimized as it's built (Daciuk et al): when a new string
+ * leaves the path of the last one, the nodes it left are finished, and
+ * each is swapped for an equal one already seen, found by hash.
+ * Then the nodes are numbered depth first, the same order makegaddag.py
+ * used, so the files come out the same.
+ */
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef uint32_t gn_t;
+typedef uint32_t bs_t;
+
+#define	SEP	0x1e
+#define MAXWORD	15		/* longer words won't fit on the board */
+#define NLET	(SEP + 1)	/* letter values 1-26, and SEP */
+#define l2b(l)	(0x01 << ((l)-1))
+
+/* name.dict layout, same as in deeper.h */
+#define DICTMAGIC	0x49445044	/* "DPDI" */
+#define DICTVERSION	1
+#define DICTBOM		0x01020304
+#define DICTALIGN	4096
+#define DICTSECTS	8
+#define DS_GADDAG	1
+#define DS_BITSET	2
+#define DS_PAIRED	3		/* each node, then its bitset */
+#define DO_DFS		0
+#define DO_BFS		1
+#define DO_VEB		2
+#define DO_HOT		3
+
+typedef struct Dictsect {
+	uint32_t type;
+	uint32_t crc;
+	uint64_t off;
+	uint64_t len;
+} dictsect_t;
+
+typedef struct Dicthead {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bom;
+	uint32_t crc;
+	uint32_t nodes;
+	uint32_t words;
+	uint32_t nsects;
+	uint32_t order;
+	dictsect_t sect[DICTSECTS];
+} dicthead_t;
+
+/* a trie node while building. edges are in letter order. */
+typedef struct Tnode {
+	uint8_t final;
+	uint8_t nedge;
+	uint8_t l[NLET];
+	int32_t c[NLET];	/* children, tnode index */
+	int32_t arc;		/* first arc in the gaddag, -1 if not yet */
+} tnode_t;
+
+tnode_t *tn = NULL;	/* node pool */
+int tncnt = 1;		/* 0 is never used */
+int tnsize = 0;
+int tnfree = 0;		/* free list, linked through c[0] */
+
+int32_t *htab = NULL;	/* minimized nodes, open addressing */
+uint32_t hsize = 0;
+uint32_t hcnt = 0;
+
+int path[MAXWORD + 2];	/* nodes along the last string, path[0] is root */
+int pathlen = 0;
+
+gn_t *arcs = NULL;	/* the output */
+int narcs = 1;		/* arc 0 is the null arc */
+int order = DO_DFS;	/* -o */
+char *ordname[] = { "dfs", "bfs", "veb", "hot" };
+
+/* for reorder: sibling groups, numbered in dfs order */
+int ngrp = 0;
+int *gstart = NULL;	/* first arc of each group */
+int *gof = NULL;	/* group of each arc */
+int *rank = NULL;	/* where each group goes, -1 if not yet */
+int *placed = NULL;	/* groups in their new order */
+int nplaced = 0;
+uint64_t *heat = NULL;	/* -o hot: profile counts, per group */
+
+int
+newnode(void)
+{
+	int n;
+	tnode_t *ntn;
+
+	if (tnfree != 0) {
+		n = tnfree;
+		tnfree = tn[n].c[0];
+	} else {
+		if (tncnt >= tnsize) {
+			tnsize = tnsize ? tnsize * 2 : (1 << 16);
+			ntn = realloc(tn, tnsize * sizeof(tnode_t));
+			if (ntn == NULL) {
+				perror("node malloc");
+				return -1;
+			}
+			tn = ntn;
+		}
+		n = tncnt++;
+	}
+	tn[n].final = 0;
+	tn[n].nedge = 0;
+	tn[n].arc = -1;
+	return n;
+}
+
+uint32_t
+nhash(int n)
+{
+	uint32_t h = 2166136261U ^ tn[n].final;
+	int i;
+
+	for (i = 0; i < tn[n].nedge; i++) {
+		h = (h ^ tn[n].l[i]) * 16777619U;
+		h = (h ^ (uint32_t)tn[n].c[i]) * 16777619U;
+	}
+	return h;
+}
+
+int
+nsame(int a, int b)
+{
+	if ((tn[a].final != tn[b].final) || (tn[a].nedge != tn[b].nedge))
+		return 0;
+	if (memcmp(tn[a].l, tn[b].l, tn[a].nedge) != 0) return 0;
+	return (memcmp(tn[a].c, tn[b].c, tn[a].nedge * sizeof(int32_t)) == 0);
+}
+
+int
+hgrow(void)
+{
+	int32_t *old = htab;
+	uint32_t osize = hsize;
+	uint32_t i, h;
+
+	hsize = hsize ? hsize * 2 : (1 << 16);
+	htab = calloc(hsize, sizeof(int32_t));
+	if (htab == NULL) {
+		perror("hash malloc");
+		return -1;
+	}
+	for (i = 0; i < osize; i++) {
+		if (old[i] == 0) continue;
+		for (h = nhash(old[i]) & (hsize - 1); htab[h] != 0; h = (h + 1) & (hsize - 1)) ;
+		htab[h] = old[i];
+	}
+	free(old);
+	return 0;
+}
+
+/* the node equal to n: an old one, and n is freed, or n, now kept. */
+int
+register_node(int n)
+{
+	uint32_t h;
+
+	if ((hcnt + 1) * 2 > hsize) {
+		if (hgrow() < 0) return -1;
+	}
+	for (h = nhash(n) & (hsize - 1); htab[h] != 0; h = (h + 1) & (hsize - 1)) {
+		if (nsame(htab[h], n)) {
+			tn[n].c[0] = tnfree;
+			tnfree = n;
+			return htab[h];
+		}
+	}
+	htab[h] = n;
+	hcnt++;
+	return n;
+}
+
+/* finish off the path below depth d. */
+int
+minimize(int d)
+{
+	int p, n;
+
+	while (pathlen > d) {
+		n = register_node(path[pathlen]);
+		if (n < 0) return -1;
+		p = path[pathlen - 1];
+		tn[p].c[tn[p].nedge - 1] = n;
+		pathlen--;
+	}
+	return 0;
+}
+
+/* add gaddag string s, of letter values. has to sort after the last one. */
+int
+insert(uint8_t *s, int len)
+{
+	int i, n, p;
+
+	for (i = 0; (i < pathlen) && (i < len); i++) {
+		p = path[i];
+		if (tn[p].l[tn[p].nedge - 1] != s[i]) break;
+	}
+	if (minimize(i) < 0) return -1;
+	for (/* i */; i < len; i++) {
+		n = newnode();
+		if (n < 0) return -1;
+		p = path[i];
+		tn[p].l[tn[p].nedge] = s[i];
+		tn[p].c[tn[p].nedge++] = n;
+		path[++pathlen] = n;
+	}
+	tn[path[pathlen]].final = 1;
+	return 0;
+}
+
+/* number node n's arcs, then its children's, depth first. */
+void
+reindex(int n)
+{
+	int i, a;
+
+	if (tn[n].arc != -1) return;
+	if (tn[n].nedge == 0) {
+		tn[n].arc = 0;
+		return;
+	}
+	a = narcs;
+	tn[n].arc = a;
+	narcs += tn[n].nedge;
+	for (i = 0; i < tn[n].nedge; i++) {
+		reindex(tn[n].c[i]);
+	}
+	for (i = 0; i < tn[n].nedge; i++) {
+		arcs[a + i] = (tn[tn[n].c[i]].arc << 8) | tn[n].l[i];
+		if (tn[tn[n].c[i]].final) arcs[a + i] |= 0x40;
+		if (i == tn[n].nedge - 1) arcs[a + i] |= 0x80;
+	}
+}
+
+/*
+ * Which nodes sit near each other. A group of sibs has to stay together,
+ * and the root's sibs at ROOTID, but the groups can go anywhere, so
+ * this just shuffles them and fixes up the children. dfs leaves them
+ * as reindex() put them. bfs goes a level at a time, so the top few
+ * levels, used by every move, are packed at the front. veb is van Emde
+ * Boas: the top half of the levels, laid out the same way, then each
+ * subtree hanging off the bottom of it, so whatever the cache line or
+ * page size, a walk down stays in few of them. hot is bfs over just
+ * the groups deeper-dprof saw used, then the rest in dfs order.
+ */
+void
+place(int g)
+{
+	rank[g] = nplaced;
+	placed[nplaced++] = g;
+}
+
+/* the group arc i of group g leads to, -1 for none */
+int
+gchild(int g, int i)
+{
+	int c = arcs[gstart[g] + i] >> 8;
+
+	return (c == 0) ? -1 : gof[c];
+}
+
+int
+glen(int g)
+{
+	return ((g + 1 < ngrp) ? gstart[g + 1] : narcs) - gstart[g];
+}
+
+int
+gheight(int g, int *ht)
+{
+	int i, c, h;
+
+	if (ht[g] > 0) return ht[g];
+	ht[g] = 1;
+	for (i = 0; i < glen(g); i++) {
+		if ((c = gchild(g, i)) < 0) continue;
+		h = gheight(c, ht) + 1;
+		if (h > ht[g]) ht[g] = h;
+	}
+	return ht[g];
+}
+
+/* lay out the h levels below the groups in r */
+int
+veb(int *r, int nr, int h)
+{
+	int *f;
+	int nf = 0, i, j, c, p0 = nplaced;
+
+	if (h <= 1) {
+		for (i = 0; i < nr; i++) {
+			if (rank[r[i]] < 0) place(r[i]);
+		}
+		return 0;
+	}
+	if (veb(r, nr, h / 2) < 0) return -1;
+	/* what hangs off the top part, in the order it was placed */
+	for (i = p0, nf = 0; i < nplaced; i++) nf += glen(placed[i]);
+	f = malloc((nf + 1) * sizeof(int));
+	if (f == NULL) {
+		perror("veb malloc");
+		return -1;
+	}
+	for (i = p0, nf = 0; i < nplaced; i++) {
+		for (j = 0; j < glen(placed[i]); j++) {
+			c = gchild(placed[i], j);
+			if ((c >= 0) && (rank[c] < 0)) f[nf++] = c;
+		}
+	}
+	for (i = 0; i < nf; i++) {
+		if ((rank[f[i]] < 0) && (veb(&f[i], 1, h - h / 2) < 0)) {
+			free(f);
+			return -1;
+		}
+	}
+	free(f);
+	return 0;
+}
+
+/* read -P prof, a count for each arc of the dfs dictionary */
+int
+readprof(char *fn)
+{
+	FILE *f;
+	uint64_t *cnt;
+	int a;
+
+	cnt = malloc(narcs * sizeof(uint64_t));
+	heat = calloc(ngrp, sizeof(uint64_t));
+	if ((cnt == NULL) || (heat == NULL)) {
+		perror("profile malloc");
+		return -1;
+	}
+	f = fopen(fn, "r");
+	if (f == NULL) {
+		perror(fn);
+		return -1;
+	}
+	if ((fread(cnt, sizeof(uint64_t), narcs, f) != narcs) || (fgetc(f) != EOF)) {
+		printf("%s isn't a profile of %d nodes\n", fn, narcs);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	for (a = 1; a < narcs; a++) {
+		heat[gof[a]] += cnt[a];
+	}
+	free(cnt);
+	return 0;
+}
+
+int
+reorder(char *prof)
+{
+	gn_t *na, v;
+	int *ht;
+	int a, g, i, c, qh;
+
+	for (a = 1; a < narcs; a++) {
+		if ((a == 1) || (arcs[a - 1] & 0x80)) ngrp++;
+	}
+	gstart = malloc(ngrp * sizeof(int));
+	gof = malloc(narcs * sizeof(int));
+	rank = malloc(ngrp * sizeof(int));
+	placed = malloc(ngrp * sizeof(int));
+	na = malloc(narcs * sizeof(gn_t));
+	if ((gstart == NULL) || (gof == NULL) || (rank == NULL) ||
+	    (placed == NULL) || (na == NULL)) {
+		perror("reorder malloc");
+		return -1;
+	}
+	for (a = 1, g = -1; a < narcs; a++) {
+		if ((a == 1) || (arcs[a - 1] & 0x80)) gstart[++g] = a;
+		gof[a] = g;
+	}
+	gof[0] = -1;
+	for (g = 0; g < ngrp; g++) rank[g] = -1;
+	if (order == DO_VEB) {
+		ht = calloc(ngrp, sizeof(int));
+		if (ht == NULL) {
+			perror("height malloc");
+			return -1;
+		}
+		g = 0;		/* the root, at ROOTID */
+		if (veb(&g, 1, gheight(0, ht)) < 0) return -1;
+		free(ht);
+	} else {
+		place(0);
+	}
+	if (order == DO_BFS) {
+		for (qh = 0; qh < nplaced; qh++) {
+			for (i = 0; i < glen(placed[qh]); i++) {
+				c = gchild(placed[qh], i);
+				if ((c >= 0) && (rank[c] < 0)) place(c);
+			}
+		}
+	} else if (order == DO_HOT) {
+		if (readprof(prof) < 0) return -1;
+		/* sorting by count alone scatters sibs' children. slower. */
+		for (qh = 0; qh < nplaced; qh++) {
+			for (i = 0; i < glen(placed[qh]); i++) {
+				c = gchild(placed[qh], i);
+				if ((c >= 0) && (rank[c] < 0) && (heat[c] > 0)) place(c);
+			}
+		}
+		for (g = 1; g < ngrp; g++) {
+			if ((rank[g] < 0) && (heat[g] > 0)) place(g);
+		}
+	}
+	/* whatever's left, as it was */
+	for (g = 0; g < ngrp; g++) {
+		if (rank[g] < 0) place(g);
+	}
+	/* rank becomes the new first arc */
+	for (i = 0, a = 1; i < ngrp; i++) {
+		g = placed[i];
+		rank[g] = a;
+		a += glen(g);
+	}
+	na[0] = arcs[0];
+	for (g = 0; g < ngrp; g++) {
+		for (i = 0; i < glen(g); i++) {
+			v = arcs[gstart[g] + i];
+			c = v >> 8;
+			na[rank[g] + i] = (v & 0xFF) | ((gn_t)(c ? rank[gof[c]] : 0) << 8);
+		}
+	}
+	free(arcs);
+	arcs = na;
+	free(gstart); free(gof); free(rank); free(placed); free(heat);
+	return 0;
+}
+
+int
+scmp(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+int
+writefile(char *fn, void *buf, size_t len)
+{
+	int fd;
+	ssize_t wrv;
+
+	fd = open(fn, O_WRONLY|O_CREAT|O_TRUNC, 00644);
+	if (fd < 0) {
+		printf("can't create %s\n", fn);
+		perror("open");
+		return -1;
+	}
+	wrv = write(fd, buf, len);
+	if (wrv != len) {
+		printf("%s only wrote %ld bytes of %lu\n", fn, (long)wrv, (unsigned long)len);
+		if (wrv < 0) perror("write");
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
+
+/* crc-32, as deeper checks it. */
+uint32_t
+crcup(uint32_t crc, const void *buf, size_t len)
+{
+	static uint32_t tab[256];
+	const uint8_t *p = buf;
+	uint32_t c;
+	int i, k;
+
+	if (tab[1] == 0) {
+		for (i = 0; i < 256; i++) {
+			c = i;
+			for (k = 0; k < 8; k++) {
+				c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+			}
+			tab[i] = c;
+		}
+	}
+	crc = ~crc;
+	while (len-- > 0) {
+		crc = tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+/* the header, then each section on a DICTALIGN boundary. */
+int
+writedict(char *fn, uint32_t words, void **data, uint32_t *types, size_t *lens, int n)
+{
+	dicthead_t *h;
+	char *buf;
+	size_t off = DICTALIGN;
+	int i, rv;
+
+	for (i = 0; i < n; i++) {
+		off += (lens[i] + DICTALIGN - 1) & ~(size_t)(DICTALIGN - 1);
+	}
+	buf = calloc(1, off);
+	if (buf == NULL) {
+		perror("dict malloc");
+		return -1;
+	}
+	h = (dicthead_t *)buf;
+	h->magic = DICTMAGIC;
+	h->version = DICTVERSION;
+	h->bom = DICTBOM;
+	h->nodes = narcs;
+	h->words = words;
+	h->nsects = n;
+	h->order = order;
+	off = DICTALIGN;
+	for (i = 0; i < n; i++) {
+		h->sect[i].type = types[i];
+		h->sect[i].off = off;
+		h->sect[i].len = lens[i];
+		h->sect[i].crc = crcup(0, data[i], lens[i]);
+		memcpy(buf + off, data[i], lens[i]);
+		off += (lens[i] + DICTALIGN - 1) & ~(size_t)(DICTALIGN - 1);
+	}
+	h->crc = crcup(0, h, sizeof(*h));
+	rv = writefile(fn, buf, off);
+	free(buf);
+	return rv;
+}
+
+int
+main(int argc, char **argv)
+{
+	char *lex = "Lexicon.txt";
+	char *prof = NULL;
+	char *name = "ENABLE";
+	char fn[1024];
+	char line[1024];
+	FILE *f;
+	char *buf, **gs;
+	bs_t *bitset, bits;
+	size_t nwords = 0, nstr = 0, bsize = 0, blen = 0;
+	void *data[3];
+	uint32_t types[3] = { DS_GADDAG, DS_BITSET, DS_PAIRED };
+	size_t lens[3];
+	gn_t *pairs;
+	int i, j, n, len, root;
+	int split = 0, paired = 0;
+	clock_t start = clock();
+
+	while ((argc > 1) && (argv[1][0] == '-')) {
+		if (strcmp(argv[1], "-s") == 0) {
+			split = 1;
+		} else if (strcmp(argv[1], "-p") == 0) {
+			paired = 1;
+		} else if ((strcmp(argv[1], "-o") == 0) && (argc > 2)) {
+			for (order = DO_HOT; order >= 0; order--) {
+				if (strcmp(argv[2], ordname[order]) == 0) break;
+			}
+			argc--; argv++;
+		} else if ((strcmp(argv[1], "-P") == 0) && (argc > 2)) {
+			prof = argv[2];
+			argc--; argv++;
+		} else {
+			order = -1;
+		}
+		if (order < 0) break;
+		argc--; argv++;
+	}
+	if ((order < 0) || ((order == DO_HOT) && (prof == NULL))) {
+		printf("usage: mkgaddag [-s] [-p] [-o dfs|bfs|veb|hot] [-P prof] [lexicon [name]]\n");
+		printf("\t-o hot needs -P name.prof, from deeper-dprof on a dfs dictionary\n");
+		return 1;
+	}
+	if (argc > 1) lex = argv[1];
+	if (argc > 2) name = argv[2];
+	f = fopen(lex, "r");
+	if (f == NULL) {
+		perror(lex);
+		return 1;
+	}
+	/* every gaddag string of every word, one after another */
+	buf = NULL;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		for (len = 0; isalpha(line[len]); len++) {
+			line[len] = toupper(line[len]);
+		}
+		if ((len == 0) || (len > MAXWORD) || ((line[len] != '\0') && !isspace(line[len]))) continue;
+		if (blen + len * (len + 2) > bsize) {
+			bsize = bsize ? bsize * 2 : (1 << 20);
+			buf = realloc(buf, bsize);
+			if (buf == NULL) {
+				perror("word malloc");
+				return 2;
+			}
+		}
+		for (i = 1; i <= len; i++) {
+			for (j = 0; j < i; j++) buf[blen++] = line[i - 1 - j];
+			if (i < len) {
+				buf[blen++] = '^';
+				memcpy(buf + blen, line + i, len - i);
+				blen += len - i;
+			}
+			buf[blen++] = '\0';
+			nstr++;
+		}
+		nwords++;
+	}
+	fclose(f);
+	gs = malloc(nstr * sizeof(char *));
+	if (gs == NULL) {
+		perror("string malloc");
+		return 2;
+	}
+	for (i = 0, j = 0; i < nstr; i++) {
+		gs[i] = buf + j;
+		j += strlen(buf + j) + 1;
+	}
+	qsort(gs, nstr, sizeof(char *), scmp);
+	printf("%lu words, %lu gaddag strings\n", nwords, nstr);
+
+	root = newnode();
+	if (root < 0) return 2;
+	path[0] = root;
+	for (i = 0; i < nstr; i++) {
+		if ((i > 0) && (strcmp(gs[i], gs[i - 1]) == 0)) continue;
+		for (len = 0; gs[i][len] != '\0'; len++) {
+			gs[i][len] &= 0x3F;	/* A-Z to 1-26, ^ to SEP */
+		}
+		if (insert((uint8_t *)gs[i], len) < 0) return 2;
+	}
+	if (minimize(0) < 0) return 2;
+	printf("%u nodes after minimizing\n", hcnt + 1);
+
+	for (i = 0, n = tn[root].nedge + 1; i < hsize; i++) {
+		if (htab[i] != 0) n += tn[htab[i]].nedge;
+	}
+	arcs = malloc(n * sizeof(gn_t));
+	if (arcs == NULL) {
+		perror("arc malloc");
+		return 2;
+	}
+	arcs[0] = 0xC0;		/* null arc: final, last, no letter, no child */
+	reindex(root);
+	if ((narcs >> 24) != 0) {
+		printf("%d arcs is too many for 24 bit children\n", narcs);
+		return 3;
+	}
+	if ((order != DO_DFS) && (reorder(prof) < 0)) return 2;
+	/* bitset[n] has the letters of arcs n to the end of its sibs */
+	bitset = malloc(narcs * sizeof(bs_t));
+	if (bitset == NULL) {
+		perror("bitset malloc");
+		return 2;
+	}
+	bits = 0;
+	for (n = narcs - 1; n >= 0; n--) {
+		if (arcs[n] & 0x80) bits = 0;
+		if (arcs[n] & 0x3F) {
+			bits |= l2b(arcs[n] & 0x3F);
+		} else {
+			bits |= 0x80000000;	/* the null arc, as mkbitset had it */
+		}
+		bitset[n] = bits;
+	}
+	data[0] = arcs;
+	lens[0] = narcs * sizeof(gn_t);
+	data[1] = bitset;
+	lens[1] = narcs * sizeof(bs_t);
+	if (paired) {
+		pairs = malloc(narcs * 2 * sizeof(gn_t));
+		if (pairs == NULL) {
+			perror("pairs malloc");
+			return 2;
+		}
+		for (n = 0; n < narcs; n++) {
+			pairs[2 * n] = arcs[n];
+			pairs[2 * n + 1] = bitset[n];
+		}
+		data[2] = pairs;
+		lens[2] = narcs * 2 * sizeof(gn_t);
+	}
+	snprintf(fn, sizeof(fn), "%s.dict", name);
+	if (writedict(fn, nwords, data, types, lens, 2 + paired) < 0) return 4;
+	if (split) {
+		snprintf(fn, sizeof(fn), "%s.gaddag", name);
+		if (writefile(fn, arcs, lens[0]) < 0) return 4;
+		snprintf(fn, sizeof(fn), "%s.bitset", name);
+		if (writefile(fn, bitset, lens[1]) < 0) return 4;
+	}
+	printf("%d arcs in %s order, %lu bytes each of gaddag and bitset, %.2f sec\n", narcs,
+	    ordname[order], (unsigned long)lens[0], (double)(clock() - start) / CLOCKS_PER_SEC);
+	return 0;
+}